@@ -15,8 +15,58 @@ var (
 	clientDir = flag.String("hostapd_client_dir", "/var/run/hostapd_grpc",
 		"Path to place client sockets in; hostapd must be able to read "+
 			"the same directory at this path!")
+	socketSendBuffer = flag.Int("hostapd_socket_sndbuf", 0,
+		"SO_SNDBUF for client sockets in bytes (0 for the system default)")
+	socketRecvBuffer = flag.Int("hostapd_socket_rcvbuf", 0,
+		"SO_RCVBUF for client sockets in bytes (0 for the system default)")
+	socketLimit = flag.Int("hostapd_socket_limit", 0,
+		"How many hostapd sockets to keep connections open to; the least "+
+			"recently used are closed past this (0 for no limit)")
+	socketPoolSize = flag.Int("hostapd_socket_pool_size", 1,
+		"How many connections to open to one hostapd socket so concurrent "+
+			"requests to it don't queue behind each other")
+	socketPoolIdleTimeout = flag.Duration("hostapd_socket_pool_idle_timeout", time.Minute,
+		"How long extra connections to a hostapd socket stay open unused "+
+			"(0 to keep them)")
+	abstractClientSockets = flag.Bool("hostapd_abstract_client_sockets", false,
+		"Bind client sockets in the abstract namespace instead of creating "+
+			"files in hostapd_client_dir; hostapd must share our network "+
+			"namespace")
+	watchControlDir = flag.Bool("hostapd_watch_control_dir", false,
+		"Track sockets coming and going with inotify instead of listing "+
+			"hostapd_control_dir for every request")
+	warmupTimeout = flag.Duration("hostapd_warmup_timeout", 0,
+		"How long to spend connecting to and pinging every hostapd socket "+
+			"before serving (0 to skip)")
+	breakerThreshold = flag.Int("hostapd_breaker_threshold", 0,
+		"Failed reconnects in a row after which requests to a hostapd socket "+
+			"fail without trying it (0 to always try)")
+	breakerCooldown = flag.Duration("hostapd_breaker_cooldown", 5*time.Second,
+		"How long requests to a hostapd socket fail without trying it before "+
+			"one is let through to see if it works again")
+	probeInterval = flag.Duration("hostapd_probe_interval", 0,
+		"How often to PING each hostapd socket to track its health (0 to "+
+			"not probe)")
+	probeTimeout = flag.Duration("hostapd_probe_timeout", 2*time.Second,
+		"How long a health probe waits for hostapd to answer")
+	probeDeadAfter = flag.Int("hostapd_probe_dead_after", 3,
+		"Failed probes in a row after which requests to a socket fail fast")
+	probeMaxBackoff = flag.Duration("hostapd_probe_max_backoff", 5*time.Minute,
+		"Longest time between probes of a dead socket")
+	useReactor = flag.Bool("hostapd_reactor", false,
+		"Multiplex all hostapd sockets on one epoll loop instead of blocking "+
+			"a thread per request")
+	useIoUring = flag.Bool("hostapd_io_uring", false,
+		"Submit hostapd requests in batches through io_uring; takes "+
+			"precedence over hostapd_reactor and falls back to it (or the "+
+			"default) if io_uring is unavailable")
 	scrapeIntervalMs = flag.Uint("hostapd_metrics_scrape_interval_ms", 0,
 		"How often to scrape metrics from hostapd in milliseconds (hostapd_metrics_scrap_interval takes precedence)")
 	scrapeInterval = flag.Duration("hostapd_metrics_scrape_interval", 5*time.Second,
 		"How often to scrape metrics from hostapd")
+	socketConcurrency = flag.Int("hostapd_socket_concurrency", 8,
+		"How many hostapd sockets a single RPC talks to at once (0 for no limit)")
+	stationResyncInterval = flag.Duration("hostapd_station_resync_interval", time.Minute,
+		"How often to fully re-read the station list from hostapd in case "+
+			"connect/disconnect events were missed")
 )
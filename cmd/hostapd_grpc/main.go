@@ -14,6 +14,8 @@ import (
 	"go.jonnrb.io/hostapd_grpc/server"
 	"go.jonnrb.io/hostapd_grpc/socket"
 	"google.golang.org/grpc"
+	"google.golang.org/grpc/health"
+	healthpb "google.golang.org/grpc/health/grpc_health_v1"
 )
 
 func main() {
@@ -23,17 +25,82 @@ func main() {
 	}
 
 	m := &socket.Manager{
-		HostapdDir: *controlDir,
-		ClientDir:  *clientDir,
+		HostapdDir:       *controlDir,
+		ClientDir:        *clientDir,
+		Limit:            *socketLimit,
+		PoolSize:         *socketPoolSize,
+		PoolIdleTimeout:  *socketPoolIdleTimeout,
+		BreakerThreshold: *breakerThreshold,
+		BreakerCooldown:  *breakerCooldown,
+		Options: socket.Options{
+			SendBuffer: *socketSendBuffer,
+			RecvBuffer: *socketRecvBuffer,
+			Abstract:   *abstractClientSockets,
+		},
+	}
+	if *useIoUring {
+		r, err := socket.NewRing()
+		if err != nil {
+			log.Println("io_uring is unavailable; not using it:", err)
+		} else {
+			defer r.Close()
+			m.Engine = r
+		}
+	}
+	if *useReactor && m.Engine == nil {
+		r, err := socket.NewReactor()
+		if err != nil {
+			log.Fatal(err)
+		}
+		defer r.Close()
+		m.Engine = r
 	}
 
-	svc := &server.Service{m}
+	stations := &server.StationTable{
+		Sockets:        m,
+		ResyncInterval: *stationResyncInterval,
+	}
+	svc := &server.Service{
+		SocketProvider: m,
+		Stations:       stations,
+		Concurrency:    *socketConcurrency,
+	}
 
 	ctx, cancel := context.WithCancel(context.Background())
 	defer cancel()
+	if *watchControlDir {
+		go func() {
+			for {
+				if err := m.Watch(ctx); err != nil {
+					log.Println("Error watching hostapd_control_dir:", err)
+				}
+				select {
+				case <-time.After(10 * time.Second):
+				case <-ctx.Done():
+					return
+				}
+			}
+		}()
+	}
+	hs := health.NewServer()
+	if *probeInterval > 0 {
+		go m.Probe(ctx, socket.ProbeOptions{
+			Interval:   *probeInterval,
+			Timeout:    *probeTimeout,
+			DeadAfter:  *probeDeadAfter,
+			MaxBackoff: *probeMaxBackoff,
+			OnChange: func(name string, h socket.Health) {
+				hs.SetServingStatus(name, servingStatus(h))
+			},
+		})
+	}
+	go stations.Run(ctx)
 	go func() {
 		g := server.NewConnectedClientsGauge()
 		prometheus.Register(g)
+		prometheus.Register(server.SocketCacheCollector{Manager: m})
+		prometheus.Register(server.ResponseCacheRequests)
+		prometheus.Register(server.SocketHealthCollector{Manager: m})
 		go (&http.Server{
 			Addr:    *metricsAddr,
 			Handler: promhttp.Handler(),
@@ -57,8 +124,21 @@ func main() {
 		}
 	}()
 
+	if *warmupTimeout > 0 {
+		ctx, cancel := context.WithTimeout(ctx, *warmupTimeout)
+		start := time.Now()
+		n, err := m.Warm(ctx)
+		cancel()
+		if err != nil {
+			log.Println("Error warming up hostapd sockets:", err)
+		} else {
+			log.Printf("Warmed up %d hostapd sockets in %v", n, time.Since(start))
+		}
+	}
+
 	s := grpc.NewServer()
 	hostapd.RegisterHostapdControlServer(s, svc)
+	healthpb.RegisterHealthServer(s, hs)
 
 	l, err := net.Listen("tcp", *grpcBindAddr)
 	if err != nil {
@@ -66,3 +146,15 @@ func main() {
 	}
 	s.Serve(l)
 }
+
+// Sockets are reported as services named after them.
+func servingStatus(h socket.Health) healthpb.HealthCheckResponse_ServingStatus {
+	switch h {
+	case socket.Healthy, socket.Degraded:
+		return healthpb.HealthCheckResponse_SERVING
+	case socket.Dead:
+		return healthpb.HealthCheckResponse_NOT_SERVING
+	default:
+		return healthpb.HealthCheckResponse_UNKNOWN
+	}
+}
@@ -0,0 +1,45 @@
+package main
+
+import (
+	"flag"
+	"time"
+)
+
+var (
+	addr = flag.String("addr", "127.0.0.1:8080",
+		"Address of the hostapd_grpc to load")
+	qps = flag.Float64("qps", 100,
+		"Target requests per second across all RPCs")
+	duration = flag.Duration("duration", 30*time.Second,
+		"How long to keep up the load")
+	mix = flag.String("mix", "Ping=1,ListClients=1,ListSockets=1",
+		"Comma separated RPC=weight pairs deciding how often each RPC is sent")
+	maxInFlight = flag.Int("max_in_flight", 1000,
+		"Requests outstanding at once before new ones are skipped; skipped "+
+			"requests mean the server is saturated")
+	timeout = flag.Duration("timeout", 10*time.Second,
+		"Deadline of each request")
+	reportInterval = flag.Duration("report_interval", 5*time.Second,
+		"How often to print progress (0 to only print the summary)")
+	socketNames = flag.String("sockets", "",
+		"Comma separated sockets to name in requests (empty for all)")
+	maxStaleness = flag.Duration("max_staleness", 0,
+		"max_staleness_ms sent with Ping and ListClients")
+
+	fakeDir = flag.String("fake_dir", "",
+		"If set, serve fake hostapd sockets in this directory for the "+
+			"duration; point hostapd_grpc's hostapd_control_dir at it")
+	fakeSockets = flag.Int("fake_sockets", 8,
+		"How many fake sockets to serve")
+	fakeStations = flag.Int("fake_stations", 30,
+		"How many stations each fake socket starts with")
+	fakeLatency = flag.Duration("fake_latency", 0,
+		"Mean of the exponentially distributed time fake sockets take to "+
+			"answer")
+	fakeDropRate = flag.Float64("fake_drop_rate", 0,
+		"Fraction of requests fake sockets never answer")
+	fakeChurn = flag.Float64("fake_churn", 0,
+		"Stations connecting or disconnecting per second on each fake socket")
+	fakeAllSta = flag.Bool("fake_all_sta", false,
+		"Whether fake sockets understand ALL_STA")
+)
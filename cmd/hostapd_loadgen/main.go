@@ -0,0 +1,319 @@
+// hostapd_loadgen sends a steady mix of RPCs to a running hostapd_grpc and
+// reports throughput, latency percentiles and a latency histogram. Failed
+// requests are reported as a series of their own so that timeouts show up
+// instead of flattering the successful ones. Requests go out at a fixed rate
+// whether or not earlier ones have finished, so a server that can't keep up
+// shows it as growing latency and skipped requests rather than as a lower
+// request rate.
+package main
+
+import (
+	"context"
+	"flag"
+	"fmt"
+	"log"
+	"math/rand"
+	"os"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"text/tabwriter"
+	"time"
+
+	"go.jonnrb.io/hostapd_grpc/fakehostapd"
+	"go.jonnrb.io/hostapd_grpc/proto"
+	"google.golang.org/grpc"
+)
+
+type rpc struct {
+	name   string
+	weight float64
+	call   func(context.Context, hostapd.HostapdControlClient, []string) error
+
+	mu sync.Mutex
+	ok []time.Duration
+	// How long the requests that failed took.
+	errors []time.Duration
+}
+
+var rpcs = map[string]func(context.Context, hostapd.HostapdControlClient, []string) error{
+	"Ping": func(ctx context.Context, c hostapd.HostapdControlClient, sockets []string) error {
+		_, err := c.Ping(ctx, &hostapd.PingRequest{
+			SocketName:     sockets,
+			MaxStalenessMs: uint32(*maxStaleness / time.Millisecond),
+		})
+		return err
+	},
+	"ListClients": func(ctx context.Context, c hostapd.HostapdControlClient, sockets []string) error {
+		_, err := c.ListClients(ctx, &hostapd.ListClientsRequest{
+			SocketName:     sockets,
+			MaxStalenessMs: uint32(*maxStaleness / time.Millisecond),
+		})
+		return err
+	},
+	"ListSockets": func(ctx context.Context, c hostapd.HostapdControlClient, _ []string) error {
+		_, err := c.ListSockets(ctx, &hostapd.ListSocketsRequest{})
+		return err
+	},
+}
+
+func main() {
+	flag.Parse()
+
+	load, err := parseMix(*mix)
+	if err != nil {
+		log.Fatal("Bad -mix: ", err)
+	}
+	if *qps <= 0 {
+		log.Fatal("-qps must be positive")
+	}
+	var sockets []string
+	if *socketNames != "" {
+		sockets = strings.Split(*socketNames, ",")
+	}
+
+	if *fakeDir != "" {
+		h, err := startFake()
+		if err != nil {
+			log.Fatal("Error starting fake hostapd: ", err)
+		}
+		defer h.Close()
+	}
+
+	cc, err := grpc.Dial(*addr, grpc.WithInsecure())
+	if err != nil {
+		log.Fatal(err)
+	}
+	defer cc.Close()
+	client := hostapd.NewHostapdControlClient(cc)
+
+	ctx, cancel := context.WithTimeout(context.Background(), *duration)
+	defer cancel()
+	if *fakeDir != "" && *fakeChurn > 0 {
+		for _, iface := range fakeIfaces {
+			go iface.Churn(ctx, *fakeChurn)
+		}
+	}
+
+	start := time.Now()
+	sent, skipped := run(ctx, client, load, sockets)
+	elapsed := time.Since(start)
+
+	summarize(os.Stdout, load, sent, skipped, elapsed)
+}
+
+func parseMix(s string) ([]*rpc, error) {
+	var mix []*rpc
+	for _, f := range strings.Split(s, ",") {
+		kv := strings.SplitN(strings.TrimSpace(f), "=", 2)
+		call, ok := rpcs[kv[0]]
+		if !ok {
+			return nil, fmt.Errorf("unknown RPC %q", kv[0])
+		}
+		w := 1.0
+		if len(kv) == 2 {
+			var err error
+			if w, err = strconv.ParseFloat(kv[1], 64); err != nil || w < 0 {
+				return nil, fmt.Errorf("bad weight %q", kv[1])
+			}
+		}
+		if w > 0 {
+			mix = append(mix, &rpc{name: kv[0], weight: w, call: call})
+		}
+	}
+	if len(mix) == 0 {
+		return nil, fmt.Errorf("nothing to send")
+	}
+	return mix, nil
+}
+
+var fakeIfaces []*fakehostapd.Interface
+
+func startFake() (*fakehostapd.Hostapd, error) {
+	h, err := fakehostapd.New(*fakeDir)
+	if err != nil {
+		return nil, err
+	}
+
+	opts := fakehostapd.Options{
+		Stations: *fakeStations,
+		DropRate: *fakeDropRate,
+		AllSta:   *fakeAllSta,
+	}
+	if *fakeLatency > 0 {
+		opts.Latency = fakehostapd.Exponential(*fakeLatency)
+	}
+	for i := 0; i < *fakeSockets; i++ {
+		opts.Seed = int64(i)
+		iface, err := h.AddInterface(fmt.Sprintf("wlan%d", i), opts)
+		if err != nil {
+			h.Close()
+			return nil, err
+		}
+		fakeIfaces = append(fakeIfaces, iface)
+	}
+	log.Printf("Serving %d fake sockets in %s", *fakeSockets, h.Dir)
+	return h, nil
+}
+
+// Sends requests at -qps until ctx is done and then waits for the ones still
+// outstanding.
+func run(ctx context.Context, client hostapd.HostapdControlClient, mix []*rpc, sockets []string) (sent, skipped int64) {
+	var total float64
+	for _, r := range mix {
+		total += r.weight
+	}
+	pick := func(rnd *rand.Rand) *rpc {
+		x := rnd.Float64() * total
+		for _, r := range mix {
+			if x -= r.weight; x < 0 {
+				return r
+			}
+		}
+		return mix[len(mix)-1]
+	}
+
+	var (
+		wg       sync.WaitGroup
+		inFlight int64
+		rnd      = rand.New(rand.NewSource(time.Now().UnixNano()))
+		interval = time.Duration(float64(time.Second) / *qps)
+		next     = time.Now()
+	)
+	var report <-chan time.Time
+	if *reportInterval > 0 {
+		t := time.NewTicker(*reportInterval)
+		defer t.Stop()
+		report = t.C
+	}
+	lastSent, lastReport := int64(0), time.Now()
+
+	for {
+		// Catch up on requests that are due rather than sleeping per request;
+		// timers aren't precise enough for high rates.
+		for now := time.Now(); !next.After(now); next = next.Add(interval) {
+			if atomic.LoadInt64(&inFlight) >= int64(*maxInFlight) {
+				skipped++
+				continue
+			}
+			sent++
+			atomic.AddInt64(&inFlight, 1)
+			wg.Add(1)
+			go func(r *rpc) {
+				defer wg.Done()
+				defer atomic.AddInt64(&inFlight, -1)
+				r.do(client, sockets)
+			}(pick(rnd))
+		}
+
+		select {
+		case <-time.After(time.Until(next)):
+		case now := <-report:
+			secs := now.Sub(lastReport).Seconds()
+			log.Printf("%.1f req/s sent, %d in flight, %d skipped so far",
+				float64(sent-lastSent)/secs, atomic.LoadInt64(&inFlight), skipped)
+			lastSent, lastReport = sent, now
+		case <-ctx.Done():
+			wg.Wait()
+			return
+		}
+	}
+}
+
+// Outstanding requests get to finish after the load stops, so this doesn't
+// take run's context.
+func (r *rpc) do(client hostapd.HostapdControlClient, sockets []string) {
+	ctx, cancel := context.WithTimeout(context.Background(), *timeout)
+	defer cancel()
+
+	start := time.Now()
+	err := r.call(ctx, client, sockets)
+	lat := time.Since(start)
+
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	if err != nil {
+		r.errors = append(r.errors, lat)
+	} else {
+		r.ok = append(r.ok, lat)
+	}
+}
+
+func summarize(out *os.File, mix []*rpc, sent, skipped int64, elapsed time.Duration) {
+	fmt.Fprintf(out, "Sent %d requests in %v (%.1f req/s); skipped %d\n\n",
+		sent, elapsed.Round(time.Millisecond), float64(sent)/elapsed.Seconds(), skipped)
+
+	for _, r := range mix {
+		sortLatencies(r.ok)
+		sortLatencies(r.errors)
+	}
+
+	w := tabwriter.NewWriter(out, 0, 8, 2, ' ', tabwriter.AlignRight)
+	fmt.Fprintln(w, "rpc\tresult\tcount\tper sec\tp50\tp90\tp99\tp999\tmax\t")
+	for _, r := range mix {
+		series := []struct {
+			result string
+			lats   []time.Duration
+		}{{"ok", r.ok}, {"error", r.errors}}
+		for _, s := range series {
+			fmt.Fprintf(w, "%s\t%s\t%d\t%.1f\t%v\t%v\t%v\t%v\t%v\t\n",
+				r.name, s.result, len(s.lats), float64(len(s.lats))/elapsed.Seconds(),
+				percentile(s.lats, 0.5), percentile(s.lats, 0.9), percentile(s.lats, 0.99),
+				percentile(s.lats, 0.999), percentile(s.lats, 1))
+		}
+	}
+	w.Flush()
+
+	for _, r := range mix {
+		fmt.Fprintf(out, "\n%s latency histogram:\n", r.name)
+		histogram(out, r.ok, r.errors)
+	}
+}
+
+func sortLatencies(lats []time.Duration) {
+	sort.Slice(lats, func(i, j int) bool { return lats[i] < lats[j] })
+}
+
+// Smallest histogram bucket; each one after is twice as wide.
+const firstBucket = 100 * time.Microsecond
+
+// Prints how many requests fell in each bucket, from the first to the one the
+// slowest request is in. ok and errors must be sorted.
+func histogram(out *os.File, ok, errors []time.Duration) {
+	total := len(ok) + len(errors)
+	if total == 0 {
+		return
+	}
+
+	w := tabwriter.NewWriter(out, 0, 8, 2, ' ', tabwriter.AlignRight)
+	fmt.Fprintln(w, "<=\tok\terrors\tcumulative\t")
+	var nOK, nErr int
+	for le := firstBucket; nOK < len(ok) || nErr < len(errors); le *= 2 {
+		bOK, bErr := countUpTo(ok[nOK:], le), countUpTo(errors[nErr:], le)
+		nOK, nErr = nOK+bOK, nErr+bErr
+		fmt.Fprintf(w, "%v\t%d\t%d\t%.2f%%\t\n",
+			le, bOK, bErr, 100*float64(nOK+nErr)/float64(total))
+	}
+	w.Flush()
+}
+
+// lats must be sorted.
+func countUpTo(lats []time.Duration, le time.Duration) int {
+	return sort.Search(len(lats), func(i int) bool { return lats[i] > le })
+}
+
+// lats must be sorted.
+func percentile(lats []time.Duration, p float64) time.Duration {
+	if len(lats) == 0 {
+		return 0
+	}
+	i := int(p*float64(len(lats))+0.5) - 1
+	if i < 0 {
+		i = 0
+	} else if i >= len(lats) {
+		i = len(lats) - 1
+	}
+	return lats[i].Round(time.Microsecond)
+}
@@ -0,0 +1,94 @@
+package fakehostapd
+
+import (
+	"bufio"
+	"encoding/json"
+	"fmt"
+	"io"
+	"io/ioutil"
+	"os"
+	"os/exec"
+)
+
+// A fake can also run in a child process so that benchmarks count only their
+// own allocations. The child is another copy of the running test binary, whose
+// TestMain has to call ServeChild before anything else.
+
+const childEnv = "FAKEHOSTAPD_CHILD"
+
+type childConfig struct {
+	Dir        string
+	Interfaces int
+	Stations   int
+	AllSta     bool
+}
+
+// Starts a child process serving interfaces named wlan0, wlan1, ... in dir.
+// Only the Stations and AllSta options are supported. stop ends the child.
+func StartChild(dir string, interfaces int, opts Options) (stop func(), err error) {
+	conf, err := json.Marshal(childConfig{
+		Dir:        dir,
+		Interfaces: interfaces,
+		Stations:   opts.Stations,
+		AllSta:     opts.AllSta,
+	})
+	if err != nil {
+		return nil, err
+	}
+
+	cmd := exec.Command(os.Args[0])
+	cmd.Env = append(os.Environ(), childEnv+"="+string(conf))
+	cmd.Stderr = os.Stderr
+	stdin, err := cmd.StdinPipe()
+	if err != nil {
+		return nil, err
+	}
+	stdout, err := cmd.StdoutPipe()
+	if err != nil {
+		return nil, err
+	}
+	if err := cmd.Start(); err != nil {
+		return nil, err
+	}
+	stop = func() {
+		stdin.Close()
+		cmd.Wait()
+	}
+	if line, err := bufio.NewReader(stdout).ReadString('\n'); err != nil || line != "ready\n" {
+		stop()
+		return nil, fmt.Errorf("fakehostapd: child didn't start: %q, %v", line, err)
+	}
+	return stop, nil
+}
+
+// If this process was started by StartChild, serves until the parent stops it
+// and then exits. Otherwise it returns right away.
+func ServeChild() {
+	env, ok := os.LookupEnv(childEnv)
+	if !ok {
+		return
+	}
+	var conf childConfig
+	if err := json.Unmarshal([]byte(env), &conf); err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(1)
+	}
+
+	h, err := New(conf.Dir)
+	if err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(1)
+	}
+	for i := 0; i < conf.Interfaces; i++ {
+		opts := Options{Stations: conf.Stations, AllSta: conf.AllSta, Seed: int64(i)}
+		if _, err := h.AddInterface(fmt.Sprintf("wlan%d", i), opts); err != nil {
+			fmt.Fprintln(os.Stderr, err)
+			os.Exit(1)
+		}
+	}
+
+	fmt.Println("ready")
+	io.Copy(ioutil.Discard, os.Stdin)
+	h.Close()
+	os.Exit(0)
+}
@@ -0,0 +1,477 @@
+// Package fakehostapd serves the hostapd control interface from memory so that
+// the rest of the repo can be exercised without a radio. A Hostapd's Dir can be
+// used as socket.Manager's HostapdDir; every interface added to it is a
+// control socket in that directory.
+//
+// Only what this repo sends is understood: PING, STATUS, STA, STA-FIRST,
+// STA-NEXT, ALL_STA (if enabled), ATTACH and DETACH. Like hostapd, each
+// interface handles one request at a time.
+package fakehostapd
+
+import (
+	"context"
+	"fmt"
+	"io/ioutil"
+	"log"
+	"math/rand"
+	"net"
+	"os"
+	"path/filepath"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+type Hostapd struct {
+	Dir string
+
+	ownDir bool
+
+	mu     sync.Mutex
+	ifaces map[string]*Interface
+}
+
+// Options configure a simulated interface. The zero value answers every
+// request immediately and has no stations.
+type Options struct {
+	// How many stations are associated to begin with.
+	Stations int
+
+	// How long each request takes to answer. Requests queue behind each other
+	// like they do on hostapd. Nil means no delay.
+	Latency Latency
+
+	// The fraction of requests that are never answered.
+	DropRate float64
+
+	// Whether ALL_STA is understood. Stock hostapd doesn't.
+	AllSta bool
+
+	// Seeds the randomness of latency, drops and churn.
+	Seed int64
+}
+
+type Interface struct {
+	Name string
+
+	opts Options
+	conn *net.UnixConn
+
+	// Requests received, including dropped ones.
+	requests uint64
+
+	mu       sync.Mutex
+	rand     *rand.Rand
+	stations []*station
+	byAddr   map[string]*station
+	monitors map[string]*net.UnixAddr
+	nextAddr int
+	closed   chan struct{}
+}
+
+type station struct {
+	addr      string
+	aid       int
+	connected time.Time
+}
+
+// Creates a fake hostapd serving sockets in dir. An empty dir means a new
+// temporary directory, which is removed on Close.
+func New(dir string) (*Hostapd, error) {
+	h := &Hostapd{Dir: dir, ifaces: make(map[string]*Interface)}
+	if dir == "" {
+		var err error
+		if h.Dir, err = ioutil.TempDir("", "fakehostapd"); err != nil {
+			return nil, err
+		}
+		h.ownDir = true
+	} else if err := os.MkdirAll(dir, 0755); err != nil {
+		return nil, err
+	}
+	return h, nil
+}
+
+// Binds the control socket for a new interface and starts answering on it.
+func (h *Hostapd) AddInterface(name string, opts Options) (*Interface, error) {
+	h.mu.Lock()
+	defer h.mu.Unlock()
+
+	if _, ok := h.ifaces[name]; ok {
+		return nil, fmt.Errorf("fakehostapd: interface %q already exists", name)
+	}
+
+	p := filepath.Join(h.Dir, name)
+	os.Remove(p)
+	conn, err := net.ListenUnixgram("unixgram", &net.UnixAddr{Name: p, Net: "unixgram"})
+	if err != nil {
+		return nil, err
+	}
+	// Clients run as the same user here, but hostapd_grpc expects to be able to
+	// talk to sockets owned by someone else.
+	os.Chmod(p, 0777)
+
+	iface := &Interface{
+		Name:     name,
+		opts:     opts,
+		conn:     conn,
+		rand:     rand.New(rand.NewSource(opts.Seed)),
+		byAddr:   make(map[string]*station),
+		monitors: make(map[string]*net.UnixAddr),
+		closed:   make(chan struct{}),
+	}
+	for i := 0; i < opts.Stations; i++ {
+		iface.add(iface.newAddr())
+	}
+	h.ifaces[name] = iface
+
+	go iface.serve()
+	return iface, nil
+}
+
+// Removes the interface's socket as if hostapd had stopped serving it.
+func (h *Hostapd) RemoveInterface(name string) error {
+	h.mu.Lock()
+	iface, ok := h.ifaces[name]
+	delete(h.ifaces, name)
+	h.mu.Unlock()
+
+	if !ok {
+		return fmt.Errorf("fakehostapd: no interface %q", name)
+	}
+	return iface.close(filepath.Join(h.Dir, name))
+}
+
+func (h *Hostapd) Interface(name string) *Interface {
+	h.mu.Lock()
+	defer h.mu.Unlock()
+
+	return h.ifaces[name]
+}
+
+func (h *Hostapd) Close() error {
+	h.mu.Lock()
+	ifaces := h.ifaces
+	h.ifaces = nil
+	h.mu.Unlock()
+
+	for name, iface := range ifaces {
+		iface.close(filepath.Join(h.Dir, name))
+	}
+	if h.ownDir {
+		return os.RemoveAll(h.Dir)
+	}
+	return nil
+}
+
+func (iface *Interface) close(path string) error {
+	close(iface.closed)
+	err := iface.conn.Close()
+	os.Remove(path)
+	return err
+}
+
+// How many requests the interface has received so far.
+func (iface *Interface) Requests() uint64 {
+	return atomic.LoadUint64(&iface.requests)
+}
+
+// The addresses of the associated stations.
+func (iface *Interface) Stations() []string {
+	iface.mu.Lock()
+	defer iface.mu.Unlock()
+
+	addrs := make([]string, len(iface.stations))
+	for i, sta := range iface.stations {
+		addrs[i] = sta.addr
+	}
+	return addrs
+}
+
+// Associates a station and tells every monitor. An empty addr makes one up;
+// the address used is returned.
+func (iface *Interface) Connect(addr string) string {
+	iface.mu.Lock()
+	if addr == "" {
+		addr = iface.newAddr()
+	}
+	if _, ok := iface.byAddr[addr]; ok {
+		iface.mu.Unlock()
+		return addr
+	}
+	iface.add(addr)
+	iface.mu.Unlock()
+
+	iface.event("AP-STA-CONNECTED " + addr)
+	return addr
+}
+
+// Disassociates a station and tells every monitor.
+func (iface *Interface) Disconnect(addr string) {
+	iface.mu.Lock()
+	sta, ok := iface.byAddr[addr]
+	if !ok {
+		iface.mu.Unlock()
+		return
+	}
+	delete(iface.byAddr, addr)
+	for i, s := range iface.stations {
+		if s == sta {
+			iface.stations = append(iface.stations[:i], iface.stations[i+1:]...)
+			break
+		}
+	}
+	iface.mu.Unlock()
+
+	iface.event("AP-STA-DISCONNECTED " + addr)
+}
+
+// Connects and disconnects random stations at about rate events per second
+// until ctx is done, keeping the station count near where it started.
+func (iface *Interface) Churn(ctx context.Context, rate float64) {
+	if rate <= 0 {
+		return
+	}
+
+	iface.mu.Lock()
+	target := len(iface.stations)
+	iface.mu.Unlock()
+
+	for {
+		iface.mu.Lock()
+		wait := time.Duration(iface.rand.ExpFloat64() / rate * float64(time.Second))
+		iface.mu.Unlock()
+
+		select {
+		case <-time.After(wait):
+		case <-ctx.Done():
+			return
+		case <-iface.closed:
+			return
+		}
+
+		// Disconnecting gets likelier the more stations there are, which pulls
+		// the count back toward the target.
+		iface.mu.Lock()
+		n := len(iface.stations)
+		var victim string
+		if n != 0 && (target == 0 || iface.rand.Float64() < float64(n)/float64(2*target)) {
+			victim = iface.stations[iface.rand.Intn(n)].addr
+		}
+		iface.mu.Unlock()
+
+		if victim != "" {
+			iface.Disconnect(victim)
+		} else {
+			iface.Connect("")
+		}
+	}
+}
+
+// iface.mu must be held.
+func (iface *Interface) newAddr() string {
+	for {
+		n := iface.nextAddr
+		iface.nextAddr++
+		addr := fmt.Sprintf("02:00:00:%02x:%02x:%02x", n>>16&0xff, n>>8&0xff, n&0xff)
+		if _, ok := iface.byAddr[addr]; !ok {
+			return addr
+		}
+	}
+}
+
+// iface.mu must be held.
+func (iface *Interface) add(addr string) {
+	sta := &station{
+		addr:      addr,
+		aid:       len(iface.stations) + 1,
+		connected: time.Now(),
+	}
+	iface.stations = append(iface.stations, sta)
+	iface.byAddr[addr] = sta
+}
+
+// Sends an unsolicited message to every attached monitor.
+func (iface *Interface) event(msg string) {
+	iface.mu.Lock()
+	defer iface.mu.Unlock()
+
+	b := []byte("<3>" + msg)
+	for name, addr := range iface.monitors {
+		if _, err := iface.conn.WriteToUnix(b, addr); err != nil {
+			// hostapd gives up on monitors that went away too.
+			delete(iface.monitors, name)
+		}
+	}
+}
+
+func (iface *Interface) serve() {
+	buf := make([]byte, 4096)
+	for {
+		n, from, err := iface.conn.ReadFromUnix(buf)
+		if err != nil {
+			select {
+			case <-iface.closed:
+				return
+			default:
+			}
+			if ne, ok := err.(net.Error); ok && ne.Temporary() {
+				continue
+			}
+			return
+		}
+		atomic.AddUint64(&iface.requests, 1)
+		if from == nil {
+			// An unbound client; there is nowhere to reply to.
+			continue
+		}
+
+		iface.mu.Lock()
+		drop := iface.opts.DropRate > 0 && iface.rand.Float64() < iface.opts.DropRate
+		var delay time.Duration
+		if iface.opts.Latency != nil {
+			delay = iface.opts.Latency(iface.rand)
+		}
+		iface.mu.Unlock()
+
+		if delay > 0 {
+			select {
+			case <-time.After(delay):
+			case <-iface.closed:
+				return
+			}
+		}
+		if drop {
+			continue
+		}
+
+		req := string(buf[:n])
+		reply := iface.handle(req, from)
+		if _, err := iface.conn.WriteToUnix([]byte(reply), from); err != nil {
+			// Most likely a reply too big for one datagram. The client never
+			// hears back, so say why.
+			log.Printf("fakehostapd: %s: can't reply to %q (%d bytes): %v", iface.Name, req, len(reply), err)
+		}
+	}
+}
+
+func (iface *Interface) handle(req string, from *net.UnixAddr) string {
+	iface.mu.Lock()
+	defer iface.mu.Unlock()
+
+	cmd, arg := req, ""
+	if i := strings.IndexByte(req, ' '); i != -1 {
+		cmd, arg = req[:i], req[i+1:]
+	}
+
+	switch cmd {
+	case "PING":
+		return "PONG\n"
+	case "ATTACH":
+		iface.monitors[from.Name] = from
+		return "OK\n"
+	case "DETACH":
+		if _, ok := iface.monitors[from.Name]; !ok {
+			return "FAIL\n"
+		}
+		delete(iface.monitors, from.Name)
+		return "OK\n"
+	case "STATUS":
+		return iface.status()
+	case "STA":
+		if sta, ok := iface.byAddr[arg]; ok {
+			return sta.info()
+		}
+		return "FAIL\n"
+	case "STA-FIRST":
+		if len(iface.stations) == 0 {
+			return ""
+		}
+		return iface.stations[0].info()
+	case "STA-NEXT":
+		for i, sta := range iface.stations {
+			if sta.addr == arg {
+				if i+1 == len(iface.stations) {
+					return ""
+				}
+				return iface.stations[i+1].info()
+			}
+		}
+		return "FAIL\n"
+	case "ALL_STA":
+		if !iface.opts.AllSta {
+			break
+		}
+		var b strings.Builder
+		for _, sta := range iface.stations {
+			b.WriteString(sta.info())
+		}
+		return b.String()
+	}
+	return "UNKNOWN COMMAND\n"
+}
+
+// iface.mu must be held.
+func (iface *Interface) status() string {
+	return fmt.Sprintf("state=ENABLED\n"+
+		"phy=phy0\n"+
+		"freq=5180\n"+
+		"num_sta_non_erp=0\n"+
+		"num_sta_no_short_slot_time=0\n"+
+		"num_sta_no_short_preamble=0\n"+
+		"olbc=0\n"+
+		"num_sta_ht_no_gf=0\n"+
+		"num_sta_no_ht=0\n"+
+		"num_sta_ht_20_mhz=0\n"+
+		"num_sta_ht40_intolerant=0\n"+
+		"olbc_ht=0\n"+
+		"ht_op_mode=0x0\n"+
+		"cac_time_seconds=0\n"+
+		"cac_time_left_seconds=N/A\n"+
+		"channel=36\n"+
+		"secondary_channel=1\n"+
+		"ieee80211n=1\n"+
+		"ieee80211ac=1\n"+
+		"beacon_int=100\n"+
+		"dtim_period=2\n"+
+		"bss[0]=%s\n"+
+		"bssid[0]=02:00:00:ff:ff:ff\n"+
+		"ssid[0]=fakehostapd\n"+
+		"num_sta[0]=%d\n",
+		iface.Name, len(iface.stations))
+}
+
+// Formats a STA reply like hostapd's. The counters grow with the time the
+// station has been connected so that successive walks see changes.
+func (sta *station) info() string {
+	secs := uint64(time.Since(sta.connected) / time.Second)
+	rxPackets, txPackets := 10+secs*20, 12+secs*25
+	return fmt.Sprintf("%s\n"+
+		"flags=[AUTH][ASSOC][AUTHORIZED][SHORT_PREAMBLE][WMM][HT][VHT]\n"+
+		"aid=%d\n"+
+		"capability=0x1511\n"+
+		"listen_interval=10\n"+
+		"supported_rates=8c 12 98 24 b0 48 60 6c\n"+
+		"timeout_next=NULLFUNC POLL\n"+
+		"dot11RSNAStatsSTAAddress=%s\n"+
+		"dot11RSNAStatsVersion=1\n"+
+		"dot11RSNAStatsSelectedPairwiseCipher=00-0f-ac-4\n"+
+		"dot11RSNAStatsTKIPLocalMICFailures=0\n"+
+		"dot11RSNAStatsTKIPRemoteMICFailures=0\n"+
+		"wpa=2\n"+
+		"AKMSuiteSelector=00-0f-ac-2\n"+
+		"hostapd_WPA_is_bridged=1\n"+
+		"rx_packets=%d\n"+
+		"tx_packets=%d\n"+
+		"rx_bytes=%d\n"+
+		"tx_bytes=%d\n"+
+		"inactive_msec=%d\n"+
+		"signal=-57\n"+
+		"rx_rate_info=866 vhtmcs 9 vhtnss 2\n"+
+		"tx_rate_info=780 vhtmcs 8 vhtnss 2\n"+
+		"connected_time=%d\n"+
+		"idle_msec=%d\n",
+		sta.addr, sta.aid, sta.addr,
+		rxPackets, txPackets, rxPackets*600, txPackets*900,
+		secs%7*100, secs, secs%7*100)
+}
@@ -0,0 +1,41 @@
+package fakehostapd
+
+import (
+	"math"
+	"math/rand"
+	"time"
+)
+
+// A distribution of how long requests take to answer. It is called with the
+// interface's own source of randomness.
+type Latency func(r *rand.Rand) time.Duration
+
+func Fixed(d time.Duration) Latency {
+	return func(*rand.Rand) time.Duration { return d }
+}
+
+// Uniform between min and max.
+func Uniform(min, max time.Duration) Latency {
+	return func(r *rand.Rand) time.Duration {
+		if max <= min {
+			return min
+		}
+		return min + time.Duration(r.Int63n(int64(max-min)))
+	}
+}
+
+// Exponential with the given mean, which is a decent model of a daemon that is
+// usually idle.
+func Exponential(mean time.Duration) Latency {
+	return func(r *rand.Rand) time.Duration {
+		return time.Duration(r.ExpFloat64() * float64(mean))
+	}
+}
+
+// Log-normal with the given median. A sigma around 1 gives the long tail of a
+// busy hostapd, where the p99 is an order of magnitude above the median.
+func LogNormal(median time.Duration, sigma float64) Latency {
+	return func(r *rand.Rand) time.Duration {
+		return time.Duration(float64(median) * math.Exp(sigma*r.NormFloat64()))
+	}
+}
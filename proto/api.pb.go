@@ -18,6 +18,8 @@ It has these top-level messages:
 	ListClientsRequest
 	Client
 	ListClientsResponse
+	WatchClientsRequest
+	ClientEvent
 */
 package hostapd
 
@@ -65,6 +67,39 @@ func (x ErrorCode) String() string {
 }
 func (ErrorCode) EnumDescriptor() ([]byte, []int) { return fileDescriptor0, []int{0} }
 
+type ClientEvent_Type int32
+
+const (
+	// The client was already connected when the watch started.
+	ClientEvent_EXISTING ClientEvent_Type = 0
+	// Marks the end of the initial EXISTING events; has no client.
+	ClientEvent_SYNCED       ClientEvent_Type = 1
+	ClientEvent_CONNECTED    ClientEvent_Type = 2
+	ClientEvent_DISCONNECTED ClientEvent_Type = 3
+	// The client's counters were refreshed.
+	ClientEvent_UPDATED ClientEvent_Type = 4
+)
+
+var ClientEvent_Type_name = map[int32]string{
+	0: "EXISTING",
+	1: "SYNCED",
+	2: "CONNECTED",
+	3: "DISCONNECTED",
+	4: "UPDATED",
+}
+var ClientEvent_Type_value = map[string]int32{
+	"EXISTING":     0,
+	"SYNCED":       1,
+	"CONNECTED":    2,
+	"DISCONNECTED": 3,
+	"UPDATED":      4,
+}
+
+func (x ClientEvent_Type) String() string {
+	return proto.EnumName(ClientEvent_Type_name, int32(x))
+}
+func (ClientEvent_Type) EnumDescriptor() ([]byte, []int) { return fileDescriptor0, []int{11, 0} }
+
 type SocketError struct {
 	Msg    string    `protobuf:"bytes,1,opt,name=msg" json:"msg,omitempty"`
 	Code   ErrorCode `protobuf:"varint,2,opt,name=code,enum=hostapd.ErrorCode" json:"code,omitempty"`
@@ -140,6 +175,9 @@ func (m *SocketList) GetSocket() []*Socket {
 type PingRequest struct {
 	// no socket name pings all sockets
 	SocketName []string `protobuf:"bytes,1,rep,name=socket_name,json=socketName" json:"socket_name,omitempty"`
+	// If nonzero, a socket that answered a ping at most this many milliseconds
+	// ago isn't pinged again.
+	MaxStalenessMs uint32 `protobuf:"varint,2,opt,name=max_staleness_ms,json=maxStalenessMs" json:"max_staleness_ms,omitempty"`
 }
 
 func (m *PingRequest) Reset()                    { *m = PingRequest{} }
@@ -154,6 +192,13 @@ func (m *PingRequest) GetSocketName() []string {
 	return nil
 }
 
+func (m *PingRequest) GetMaxStalenessMs() uint32 {
+	if m != nil {
+		return m.MaxStalenessMs
+	}
+	return 0
+}
+
 type Pong struct {
 	SocketName string       `protobuf:"bytes,1,opt,name=socket_name,json=socketName" json:"socket_name,omitempty"`
 	Error      *SocketError `protobuf:"bytes,2,opt,name=error" json:"error,omitempty"`
@@ -196,6 +241,9 @@ func (m *PongResponse) GetPong() []*Pong {
 
 type ListClientsRequest struct {
 	SocketName []string `protobuf:"bytes,1,rep,name=socket_name,json=socketName" json:"socket_name,omitempty"`
+	// If nonzero, clients listed from a socket at most this many milliseconds
+	// ago may be returned instead of asking hostapd again.
+	MaxStalenessMs uint32 `protobuf:"varint,2,opt,name=max_staleness_ms,json=maxStalenessMs" json:"max_staleness_ms,omitempty"`
 }
 
 func (m *ListClientsRequest) Reset()                    { *m = ListClientsRequest{} }
@@ -210,6 +258,13 @@ func (m *ListClientsRequest) GetSocketName() []string {
 	return nil
 }
 
+func (m *ListClientsRequest) GetMaxStalenessMs() uint32 {
+	if m != nil {
+		return m.MaxStalenessMs
+	}
+	return 0
+}
+
 type Client struct {
 	Addr          string   `protobuf:"bytes,1,opt,name=addr" json:"addr,omitempty"`
 	Flag          []string `protobuf:"bytes,2,rep,name=flag" json:"flag,omitempty"`
@@ -314,6 +369,46 @@ func (m *ListClientsResponse) GetError() []*SocketError {
 	return nil
 }
 
+type WatchClientsRequest struct {
+	SocketName []string `protobuf:"bytes,1,rep,name=socket_name,json=socketName" json:"socket_name,omitempty"`
+}
+
+func (m *WatchClientsRequest) Reset()                    { *m = WatchClientsRequest{} }
+func (m *WatchClientsRequest) String() string            { return proto.CompactTextString(m) }
+func (*WatchClientsRequest) ProtoMessage()               {}
+func (*WatchClientsRequest) Descriptor() ([]byte, []int) { return fileDescriptor0, []int{10} }
+
+func (m *WatchClientsRequest) GetSocketName() []string {
+	if m != nil {
+		return m.SocketName
+	}
+	return nil
+}
+
+type ClientEvent struct {
+	Type   ClientEvent_Type `protobuf:"varint,1,opt,name=type,enum=hostapd.ClientEvent_Type" json:"type,omitempty"`
+	Client *Client          `protobuf:"bytes,2,opt,name=client" json:"client,omitempty"`
+}
+
+func (m *ClientEvent) Reset()                    { *m = ClientEvent{} }
+func (m *ClientEvent) String() string            { return proto.CompactTextString(m) }
+func (*ClientEvent) ProtoMessage()               {}
+func (*ClientEvent) Descriptor() ([]byte, []int) { return fileDescriptor0, []int{11} }
+
+func (m *ClientEvent) GetType() ClientEvent_Type {
+	if m != nil {
+		return m.Type
+	}
+	return ClientEvent_EXISTING
+}
+
+func (m *ClientEvent) GetClient() *Client {
+	if m != nil {
+		return m.Client
+	}
+	return nil
+}
+
 func init() {
 	proto.RegisterType((*SocketError)(nil), "hostapd.SocketError")
 	proto.RegisterType((*ListSocketsRequest)(nil), "hostapd.ListSocketsRequest")
@@ -325,7 +420,10 @@ func init() {
 	proto.RegisterType((*ListClientsRequest)(nil), "hostapd.ListClientsRequest")
 	proto.RegisterType((*Client)(nil), "hostapd.Client")
 	proto.RegisterType((*ListClientsResponse)(nil), "hostapd.ListClientsResponse")
+	proto.RegisterType((*WatchClientsRequest)(nil), "hostapd.WatchClientsRequest")
+	proto.RegisterType((*ClientEvent)(nil), "hostapd.ClientEvent")
 	proto.RegisterEnum("hostapd.ErrorCode", ErrorCode_name, ErrorCode_value)
+	proto.RegisterEnum("hostapd.ClientEvent_Type", ClientEvent_Type_name, ClientEvent_Type_value)
 }
 
 // Reference imports to suppress errors if they are not otherwise used.
@@ -342,6 +440,9 @@ type HostapdControlClient interface {
 	ListSockets(ctx context.Context, in *ListSocketsRequest, opts ...grpc.CallOption) (*SocketList, error)
 	Ping(ctx context.Context, in *PingRequest, opts ...grpc.CallOption) (*PongResponse, error)
 	ListClients(ctx context.Context, in *ListClientsRequest, opts ...grpc.CallOption) (*ListClientsResponse, error)
+	// Sends every client currently connected followed by a SYNCED event, then
+	// streams changes as hostapd reports them.
+	WatchClients(ctx context.Context, in *WatchClientsRequest, opts ...grpc.CallOption) (HostapdControl_WatchClientsClient, error)
 }
 
 type hostapdControlClient struct {
@@ -379,12 +480,47 @@ func (c *hostapdControlClient) ListClients(ctx context.Context, in *ListClientsR
 	return out, nil
 }
 
+func (c *hostapdControlClient) WatchClients(ctx context.Context, in *WatchClientsRequest, opts ...grpc.CallOption) (HostapdControl_WatchClientsClient, error) {
+	stream, err := grpc.NewClientStream(ctx, &_HostapdControl_serviceDesc.Streams[0], c.cc, "/hostapd.HostapdControl/WatchClients", opts...)
+	if err != nil {
+		return nil, err
+	}
+	x := &hostapdControlWatchClientsClient{stream}
+	if err := x.ClientStream.SendMsg(in); err != nil {
+		return nil, err
+	}
+	if err := x.ClientStream.CloseSend(); err != nil {
+		return nil, err
+	}
+	return x, nil
+}
+
+type HostapdControl_WatchClientsClient interface {
+	Recv() (*ClientEvent, error)
+	grpc.ClientStream
+}
+
+type hostapdControlWatchClientsClient struct {
+	grpc.ClientStream
+}
+
+func (x *hostapdControlWatchClientsClient) Recv() (*ClientEvent, error) {
+	m := new(ClientEvent)
+	if err := x.ClientStream.RecvMsg(m); err != nil {
+		return nil, err
+	}
+	return m, nil
+}
+
 // Server API for HostapdControl service
 
 type HostapdControlServer interface {
 	ListSockets(context.Context, *ListSocketsRequest) (*SocketList, error)
 	Ping(context.Context, *PingRequest) (*PongResponse, error)
 	ListClients(context.Context, *ListClientsRequest) (*ListClientsResponse, error)
+	// Sends every client currently connected followed by a SYNCED event, then
+	// streams changes as hostapd reports them.
+	WatchClients(*WatchClientsRequest, HostapdControl_WatchClientsServer) error
 }
 
 func RegisterHostapdControlServer(s *grpc.Server, srv HostapdControlServer) {
@@ -445,6 +581,27 @@ func _HostapdControl_ListClients_Handler(srv interface{}, ctx context.Context, d
 	return interceptor(ctx, in, info, handler)
 }
 
+func _HostapdControl_WatchClients_Handler(srv interface{}, stream grpc.ServerStream) error {
+	m := new(WatchClientsRequest)
+	if err := stream.RecvMsg(m); err != nil {
+		return err
+	}
+	return srv.(HostapdControlServer).WatchClients(m, &hostapdControlWatchClientsServer{stream})
+}
+
+type HostapdControl_WatchClientsServer interface {
+	Send(*ClientEvent) error
+	grpc.ServerStream
+}
+
+type hostapdControlWatchClientsServer struct {
+	grpc.ServerStream
+}
+
+func (x *hostapdControlWatchClientsServer) Send(m *ClientEvent) error {
+	return x.ServerStream.SendMsg(m)
+}
+
 var _HostapdControl_serviceDesc = grpc.ServiceDesc{
 	ServiceName: "hostapd.HostapdControl",
 	HandlerType: (*HostapdControlServer)(nil),
@@ -462,47 +619,62 @@ var _HostapdControl_serviceDesc = grpc.ServiceDesc{
 			Handler:    _HostapdControl_ListClients_Handler,
 		},
 	},
-	Streams:  []grpc.StreamDesc{},
+	Streams: []grpc.StreamDesc{
+		{
+			StreamName:    "WatchClients",
+			Handler:       _HostapdControl_WatchClients_Handler,
+			ServerStreams: true,
+		},
+	},
 	Metadata: "api.proto",
 }
 
 func init() { proto.RegisterFile("api.proto", fileDescriptor0) }
 
 var fileDescriptor0 = []byte{
-	// 558 bytes of a gzipped FileDescriptorProto
-	0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0x84, 0x94, 0xdd, 0x6e, 0xd3, 0x4c,
-	0x10, 0x86, 0xeb, 0xc4, 0x71, 0xe2, 0x71, 0x93, 0x2f, 0xdf, 0xb4, 0x15, 0x26, 0x2d, 0x22, 0x58,
-	0x82, 0x46, 0x3d, 0x88, 0x44, 0x50, 0x24, 0x4e, 0x43, 0x62, 0x89, 0x42, 0x08, 0x91, 0xdb, 0x03,
-	0xce, 0x8c, 0x6b, 0x2f, 0xc1, 0x90, 0x78, 0xcd, 0x7a, 0x91, 0xc2, 0x25, 0x70, 0x83, 0x5c, 0x0f,
-	0xda, 0x9f, 0xb8, 0xf9, 0x41, 0xea, 0xd9, 0x7a, 0x9e, 0x77, 0x76, 0x26, 0xef, 0xcc, 0x06, 0xec,
-	0x28, 0x4f, 0xfb, 0x39, 0xa3, 0x9c, 0x62, 0xfd, 0x2b, 0x2d, 0x78, 0x94, 0x27, 0xde, 0x67, 0x70,
-	0x6e, 0x68, 0xfc, 0x9d, 0x70, 0x9f, 0x31, 0xca, 0xb0, 0x0d, 0xd5, 0x55, 0xb1, 0x70, 0x8d, 0xae,
-	0xd1, 0xb3, 0x03, 0x71, 0xc4, 0x17, 0x60, 0xc6, 0x34, 0x21, 0x6e, 0xa5, 0x6b, 0xf4, 0x5a, 0x03,
-	0xec, 0xeb, 0xc4, 0xbe, 0xd4, 0x8f, 0x69, 0x42, 0x02, 0xc9, 0xf1, 0x11, 0xd4, 0xe3, 0x90, 0x30,
-	0x96, 0x51, 0xb7, 0xda, 0x35, 0x7a, 0xb5, 0xc0, 0x8a, 0x7d, 0xf1, 0xe5, 0x9d, 0x02, 0x4e, 0xd3,
-	0x82, 0xab, 0x2a, 0x45, 0x40, 0x7e, 0xfc, 0x24, 0x05, 0xf7, 0x2e, 0xc0, 0x52, 0x11, 0x44, 0x30,
-	0xb3, 0x68, 0x45, 0x74, 0x4d, 0x79, 0xf6, 0x86, 0x00, 0x8a, 0x8a, 0x4c, 0xbc, 0x04, 0xab, 0x90,
-	0x5f, 0xae, 0xd1, 0xad, 0xf6, 0x9c, 0xc1, 0x7f, 0x65, 0x13, 0x4a, 0x14, 0x68, 0xec, 0xf5, 0xc1,
-	0x99, 0xa7, 0xd9, 0x42, 0xd7, 0xc0, 0xa7, 0xe0, 0x28, 0x10, 0xea, 0x02, 0xd5, 0x9e, 0x1d, 0x80,
-	0x0a, 0xcd, 0x44, 0x99, 0x1b, 0x30, 0xe7, 0x34, 0x5b, 0x1c, 0x0a, 0x8d, 0x5d, 0x21, 0x5e, 0x41,
-	0x8d, 0x88, 0xdf, 0x2b, 0x5d, 0x70, 0x06, 0xa7, 0x7b, 0x0d, 0x48, 0x2f, 0x02, 0x25, 0xf1, 0x5e,
-	0xc2, 0xb1, 0xb8, 0x34, 0x20, 0x45, 0x4e, 0xb3, 0x82, 0xe0, 0x33, 0x30, 0x73, 0x9a, 0x2d, 0x74,
-	0xef, 0xcd, 0x32, 0x55, 0x8a, 0x24, 0xf2, 0x86, 0xca, 0xa2, 0xf1, 0x32, 0x25, 0x59, 0x69, 0xd1,
-	0xc3, 0xed, 0xff, 0xae, 0x80, 0xa5, 0x72, 0x84, 0x89, 0x51, 0x92, 0xb0, 0x8d, 0x89, 0xe2, 0x2c,
-	0x62, 0x5f, 0x96, 0xd1, 0xc2, 0xad, 0xc8, 0x44, 0x79, 0xc6, 0xe7, 0xd0, 0x8a, 0x69, 0x96, 0x91,
-	0x98, 0x93, 0x24, 0xe4, 0xe9, 0x8a, 0xc8, 0x61, 0x35, 0x83, 0x66, 0x19, 0xbd, 0x4d, 0x57, 0x04,
-	0xcf, 0xc1, 0x4e, 0x93, 0x25, 0x09, 0x57, 0x05, 0x89, 0x5d, 0x53, 0x2a, 0x1a, 0x22, 0xf0, 0xa1,
-	0x20, 0x31, 0x3e, 0x01, 0x60, 0xeb, 0x30, 0x8f, 0xe4, 0x3c, 0xdd, 0x9a, 0xa4, 0x36, 0x5b, 0xcf,
-	0x55, 0x40, 0x60, 0x7e, 0x8f, 0x2d, 0x85, 0x79, 0x89, 0x1f, 0x43, 0x83, 0xad, 0xc3, 0xbb, 0x5f,
-	0x9c, 0x14, 0x6e, 0x5d, 0xc2, 0x3a, 0x5b, 0xbf, 0x11, 0x9f, 0x02, 0xf1, 0x0d, 0x6a, 0x28, 0xc4,
-	0x35, 0xda, 0xf3, 0xc2, 0xde, 0x9f, 0x90, 0xf7, 0x0d, 0x4e, 0x76, 0x2c, 0xd4, 0xe6, 0x5f, 0x82,
-	0x15, 0xcb, 0xd0, 0xc1, 0xea, 0x28, 0x65, 0xa0, 0xf1, 0xf6, 0x84, 0xab, 0x0f, 0x4c, 0xf8, 0xea,
-	0x35, 0xd8, 0xe5, 0xf6, 0xa3, 0x05, 0x95, 0x8f, 0xef, 0xdb, 0x47, 0x78, 0x06, 0xff, 0x4f, 0xfc,
-	0xd1, 0x64, 0x7a, 0x3d, 0xf3, 0x43, 0xff, 0xd3, 0xd8, 0xf7, 0x27, 0xfe, 0xa4, 0x6d, 0xe0, 0x31,
-	0x34, 0xae, 0x67, 0xb7, 0x7e, 0x30, 0x1b, 0x4d, 0xdb, 0x95, 0xc1, 0x1f, 0x03, 0x5a, 0x6f, 0xd5,
-	0xc5, 0x63, 0x9a, 0x71, 0x46, 0x97, 0x38, 0x02, 0x67, 0xeb, 0x79, 0xe0, 0x79, 0x59, 0xf8, 0xf0,
-	0xd1, 0x74, 0x4e, 0xf6, 0xba, 0x12, 0x12, 0xef, 0x08, 0x87, 0x60, 0x8a, 0xb5, 0xc7, 0xfb, 0xa6,
-	0xb7, 0x5e, 0x41, 0xe7, 0x6c, 0x77, 0xe3, 0xb4, 0x33, 0xde, 0x11, 0xbe, 0x53, 0x95, 0xb5, 0x65,
-	0x7b, 0x95, 0x77, 0x77, 0xb1, 0x73, 0xf1, 0x6f, 0xb8, 0xb9, 0xeb, 0xce, 0x92, 0x7f, 0x2b, 0xaf,
-	0xfe, 0x06, 0x00, 0x00, 0xff, 0xff, 0xa6, 0xdd, 0xac, 0xfa, 0x63, 0x04, 0x00, 0x00,
+	// 694 bytes of a gzipped FileDescriptorProto
+	0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0xad, 0x54, 0xdb, 0x6e, 0xd3, 0x40,
+	0x10, 0x6d, 0x62, 0xd7, 0x89, 0xc7, 0x49, 0x08, 0xdb, 0x56, 0xa4, 0x69, 0x11, 0xb0, 0x12, 0x50,
+	0x55, 0x22, 0x82, 0xa0, 0x22, 0x5e, 0x83, 0x63, 0x20, 0xd0, 0xba, 0x91, 0x13, 0x44, 0x79, 0x32,
+	0xae, 0xb3, 0xa4, 0x81, 0xc4, 0x0e, 0xde, 0x05, 0xa5, 0x9f, 0xc0, 0x4f, 0xf0, 0x17, 0xfc, 0x1f,
+	0x7b, 0x71, 0x9d, 0xd4, 0x2d, 0x42, 0x48, 0xbc, 0xed, 0x9c, 0x73, 0x66, 0x66, 0x67, 0x67, 0x76,
+	0xc0, 0x0c, 0xe6, 0x93, 0xd6, 0x3c, 0x89, 0x59, 0x8c, 0x4a, 0x67, 0x31, 0x65, 0xc1, 0x7c, 0x84,
+	0x3f, 0x82, 0x35, 0x88, 0xc3, 0x2f, 0x84, 0x39, 0x49, 0x12, 0x27, 0xa8, 0x0e, 0xda, 0x8c, 0x8e,
+	0x1b, 0x85, 0xbb, 0x85, 0x3d, 0xd3, 0x13, 0x47, 0xf4, 0x00, 0xf4, 0x30, 0x1e, 0x91, 0x46, 0x91,
+	0x43, 0xb5, 0x36, 0x6a, 0xa5, 0x8e, 0x2d, 0xa9, 0xb7, 0x39, 0xe3, 0x49, 0x1e, 0xdd, 0x82, 0x52,
+	0xe8, 0x93, 0x24, 0x89, 0xe2, 0x86, 0xc6, 0xa5, 0xeb, 0x9e, 0x11, 0x3a, 0xc2, 0xc2, 0x9b, 0x80,
+	0x0e, 0x27, 0x94, 0xa9, 0x2c, 0xd4, 0x23, 0x5f, 0xbf, 0x11, 0xca, 0xf0, 0x2e, 0x18, 0x0a, 0x41,
+	0x08, 0xf4, 0x28, 0x98, 0x91, 0x34, 0xa7, 0x3c, 0xe3, 0x03, 0x00, 0xc5, 0x0a, 0x4f, 0xf4, 0x10,
+	0x0c, 0x2a, 0x2d, 0xae, 0xd1, 0xf6, 0xac, 0xf6, 0x8d, 0xec, 0x12, 0x4a, 0xe4, 0xa5, 0x34, 0x3e,
+	0x01, 0xab, 0x3f, 0x89, 0xc6, 0x69, 0x0e, 0x74, 0x07, 0x2c, 0x45, 0xf8, 0x69, 0x02, 0x8d, 0x27,
+	0x00, 0x05, 0xb9, 0x1c, 0x41, 0x7b, 0x50, 0x9f, 0x05, 0x0b, 0x9f, 0xc7, 0x9a, 0x92, 0x88, 0x50,
+	0xea, 0xcf, 0xa8, 0xac, 0xb3, 0xea, 0xd5, 0x38, 0x3e, 0xb8, 0x80, 0x8f, 0x28, 0x1e, 0x80, 0xde,
+	0x8f, 0xa3, 0xf1, 0xd5, 0x90, 0x85, 0x5c, 0xc8, 0x7d, 0x58, 0x27, 0xe2, 0x65, 0x64, 0x1c, 0xab,
+	0xbd, 0x99, 0xbb, 0xaa, 0x7c, 0x35, 0x4f, 0x49, 0xf0, 0x13, 0xa8, 0x88, 0xa0, 0x1e, 0xa1, 0xf3,
+	0x38, 0xa2, 0x04, 0xdd, 0x03, 0x9d, 0x1f, 0xc6, 0x69, 0x95, 0xd5, 0xcc, 0x55, 0x8a, 0x24, 0x85,
+	0x7d, 0xf5, 0x98, 0xf6, 0x74, 0x42, 0xa2, 0xec, 0x31, 0xff, 0x67, 0xa1, 0x3f, 0x8a, 0x60, 0xa8,
+	0xe8, 0xa2, 0x31, 0xc1, 0x68, 0x94, 0x5c, 0x34, 0x46, 0x9c, 0x05, 0xf6, 0x69, 0x1a, 0x8c, 0xb9,
+	0xb3, 0x48, 0x21, 0xcf, 0xe8, 0x3e, 0xd4, 0xc2, 0x38, 0x8a, 0x48, 0xc8, 0xc8, 0xc8, 0x67, 0x13,
+	0x7e, 0x01, 0x4d, 0x86, 0xae, 0x66, 0xe8, 0x90, 0x83, 0x68, 0x07, 0xcc, 0xc9, 0x68, 0x4a, 0x78,
+	0x6a, 0x12, 0x36, 0x74, 0xa9, 0x28, 0x0b, 0xe0, 0x88, 0xdb, 0xe8, 0x36, 0x40, 0xb2, 0xf0, 0xe7,
+	0x81, 0x9c, 0x91, 0xc6, 0xba, 0x64, 0xcd, 0x64, 0xd1, 0x57, 0x80, 0xa0, 0xd9, 0x92, 0x36, 0x14,
+	0xcd, 0x32, 0x7a, 0x1b, 0xca, 0xdc, 0xfb, 0xf4, 0x9c, 0x11, 0xda, 0x28, 0x49, 0xb2, 0x94, 0x2c,
+	0x5e, 0x08, 0x53, 0x50, 0xec, 0x82, 0x2a, 0x2b, 0x8a, 0xa5, 0x54, 0xee, 0xd5, 0xcc, 0x7c, 0x2f,
+	0xf1, 0x67, 0xd8, 0xb8, 0xf4, 0xd8, 0x69, 0x9b, 0xf8, 0x38, 0x86, 0x12, 0xba, 0x32, 0x8e, 0x4a,
+	0xe9, 0xa5, 0xf4, 0xea, 0x2c, 0x68, 0x7f, 0x9b, 0x85, 0x67, 0xb0, 0xf1, 0x3e, 0x60, 0xe1, 0xd9,
+	0x3f, 0x76, 0x16, 0xff, 0x2a, 0x80, 0xa5, 0x7c, 0x9c, 0xef, 0x22, 0xe7, 0x23, 0xd0, 0xd9, 0xf9,
+	0x5c, 0x4d, 0x66, 0xad, 0xbd, 0x9d, 0xbb, 0x9a, 0xd4, 0xb4, 0x86, 0x5c, 0xe0, 0x49, 0xd9, 0x4a,
+	0x2d, 0x6a, 0x5e, 0xff, 0x54, 0x0b, 0x76, 0x41, 0x17, 0x6e, 0xa8, 0x02, 0x65, 0xe7, 0xa4, 0x37,
+	0x18, 0xf6, 0xdc, 0x57, 0xf5, 0x35, 0x04, 0xfc, 0x17, 0x7f, 0x70, 0x6d, 0xa7, 0x5b, 0x2f, 0xa0,
+	0x2a, 0x98, 0xf6, 0xb1, 0xeb, 0x3a, 0xf6, 0x90, 0x9b, 0x45, 0xbe, 0x49, 0x2a, 0xdd, 0xde, 0x60,
+	0x89, 0x68, 0xc8, 0x82, 0xd2, 0xbb, 0x7e, 0xb7, 0x23, 0x0c, 0x7d, 0xff, 0x39, 0x98, 0xd9, 0x06,
+	0x41, 0x06, 0x14, 0x8f, 0xdf, 0xf2, 0x70, 0x5b, 0x70, 0xb3, 0xeb, 0x74, 0xba, 0x87, 0x3d, 0xd7,
+	0xf1, 0x9d, 0x13, 0xdb, 0x71, 0xba, 0x32, 0x32, 0xcf, 0xd9, 0x73, 0x87, 0x8e, 0xe7, 0x76, 0x0e,
+	0xeb, 0xc5, 0xf6, 0xcf, 0x22, 0xd4, 0x5e, 0xab, 0x4b, 0xda, 0x71, 0xc4, 0x92, 0x78, 0x8a, 0x3a,
+	0x60, 0xad, 0xac, 0x18, 0xb4, 0x93, 0x15, 0x71, 0x75, 0xf1, 0x34, 0x37, 0x72, 0x5d, 0x10, 0x12,
+	0xbc, 0x86, 0x0e, 0xf8, 0x07, 0xe7, 0xab, 0x03, 0x2d, 0x9b, 0xb4, 0xb2, 0x49, 0x9a, 0x5b, 0x97,
+	0xff, 0x62, 0x3a, 0x09, 0xdc, 0xed, 0x8d, 0xca, 0x9c, 0x76, 0x2d, 0x97, 0xf9, 0x72, 0x2f, 0x9b,
+	0xbb, 0xd7, 0x93, 0x59, 0xac, 0x97, 0x50, 0x59, 0x1d, 0x01, 0xb4, 0xd4, 0x5f, 0x33, 0x19, 0xcd,
+	0xcd, 0xeb, 0x5a, 0x8b, 0xd7, 0x1e, 0x17, 0x4e, 0x0d, 0xb9, 0xe2, 0x9f, 0xfe, 0x06, 0x2e, 0x12,
+	0x47, 0xd5, 0xef, 0x05, 0x00, 0x00,
 }
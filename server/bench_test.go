@@ -0,0 +1,235 @@
+package server
+
+import (
+	"context"
+	"flag"
+	"fmt"
+	"io/ioutil"
+	"net"
+	"os"
+	"testing"
+	"time"
+
+	"go.jonnrb.io/hostapd_grpc/fakehostapd"
+	hostapd "go.jonnrb.io/hostapd_grpc/proto"
+	"go.jonnrb.io/hostapd_grpc/socket"
+	"google.golang.org/grpc"
+	"google.golang.org/grpc/test/bufconn"
+)
+
+// End to end benchmarks of the gRPC service over an in-memory listener against
+// fakehostapd sockets. Compare runs with benchstat against
+// testdata/bench_baseline.txt, e.g.
+//
+//	go test -run XXX -bench . -count 6 ./server -engine=reactor
+//
+// The baseline was recorded on one CPU with the flags listed at its top, which
+// call the Service directly rather than over gRPC. Record a fresh one the same
+// way before comparing on another machine.
+//
+// Besides the usual ns/op, B/op and allocs/op, each result reports how many
+// control socket requests one RPC cost (roundtrips/op). Allocations include the
+// fake hostapd's since it runs in the same process.
+var (
+	benchTransport = flag.String("transport", "bufconn",
+		"How RPCs reach the service: bufconn, or direct to call it without gRPC")
+	benchEngine = flag.String("engine", "cgo",
+		"How requests reach the sockets: cgo, reactor or io_uring")
+	benchConcurrency = flag.Int("concurrency", 8,
+		"Same as hostapd_grpc's hostapd_socket_concurrency")
+	benchAllSta = flag.Bool("all_sta", false,
+		"Whether the fake sockets understand ALL_STA")
+	benchStationTable = flag.Bool("station_table", false,
+		"Answer ListClients from a station table kept up to date by events")
+)
+
+var (
+	benchSockets  = []int{1, 8, 64}
+	benchStations = []int{1, 10, 100, 1000}
+)
+
+// The fake sends a whole ALL_STA reply in one datagram like hostapd would, and
+// the biggest that fit under the default SO_SNDBUF hold a few hundred stations.
+const maxAllStaStations = 100
+
+// The RPCs benchmarked, which both *Service and grpcClient have.
+type benchClient interface {
+	Ping(context.Context, *hostapd.PingRequest) (*hostapd.PongResponse, error)
+	ListSockets(context.Context, *hostapd.ListSocketsRequest) (*hostapd.SocketList, error)
+	ListClients(context.Context, *hostapd.ListClientsRequest) (*hostapd.ListClientsResponse, error)
+}
+
+type grpcClient struct {
+	c hostapd.HostapdControlClient
+}
+
+func (g grpcClient) Ping(ctx context.Context, req *hostapd.PingRequest) (*hostapd.PongResponse, error) {
+	return g.c.Ping(ctx, req)
+}
+
+func (g grpcClient) ListSockets(ctx context.Context, req *hostapd.ListSocketsRequest) (*hostapd.SocketList, error) {
+	return g.c.ListSockets(ctx, req)
+}
+
+func (g grpcClient) ListClients(ctx context.Context, req *hostapd.ListClientsRequest) (*hostapd.ListClientsResponse, error) {
+	return g.c.ListClients(ctx, req)
+}
+
+func BenchmarkPing(b *testing.B) {
+	benchmarkRPC(b, func(ctx context.Context, c benchClient, _ int) error {
+		_, err := c.Ping(ctx, &hostapd.PingRequest{})
+		return err
+	})
+}
+
+func BenchmarkListSockets(b *testing.B) {
+	benchmarkRPC(b, func(ctx context.Context, c benchClient, _ int) error {
+		_, err := c.ListSockets(ctx, &hostapd.ListSocketsRequest{})
+		return err
+	})
+}
+
+func BenchmarkListClients(b *testing.B) {
+	benchmarkRPC(b, func(ctx context.Context, c benchClient, stations int) error {
+		res, err := c.ListClients(ctx, &hostapd.ListClientsRequest{})
+		if err == nil && len(res.Client) != stations {
+			err = fmt.Errorf("got %d clients; want %d", len(res.Client), stations)
+		}
+		return err
+	})
+}
+
+// call is given how many stations there are on all the sockets together.
+func benchmarkRPC(b *testing.B, call func(ctx context.Context, c benchClient, stations int) error) {
+	for _, nSockets := range benchSockets {
+		for _, nStations := range benchStations {
+			b.Run(fmt.Sprintf("sockets=%d/stations=%d", nSockets, nStations), func(b *testing.B) {
+				if *benchAllSta && nStations > maxAllStaStations {
+					b.Skip("ALL_STA replies this big don't fit in a datagram")
+				}
+				client, ifaces := startBench(b, nSockets, nStations)
+				ctx := context.Background()
+
+				b.ReportAllocs()
+				b.ResetTimer()
+				before := requests(ifaces)
+				for i := 0; i < b.N; i++ {
+					if err := call(ctx, client, nSockets*nStations); err != nil {
+						b.Fatal(err)
+					}
+				}
+				b.ReportMetric(float64(requests(ifaces)-before)/float64(b.N), "roundtrips/op")
+			})
+		}
+	}
+}
+
+// Serves a Service over bufconn for nSockets fake sockets with nStations each,
+// or with -transport=direct returns the Service itself.
+func startBench(b *testing.B, nSockets, nStations int) (benchClient, []*fakehostapd.Interface) {
+	h, err := fakehostapd.New("")
+	if err != nil {
+		b.Fatal(err)
+	}
+	b.Cleanup(func() { h.Close() })
+
+	var ifaces []*fakehostapd.Interface
+	for i := 0; i < nSockets; i++ {
+		iface, err := h.AddInterface(fmt.Sprintf("wlan%d", i), fakehostapd.Options{
+			Stations: nStations,
+			AllSta:   *benchAllSta,
+			Seed:     int64(i),
+		})
+		if err != nil {
+			b.Fatal(err)
+		}
+		ifaces = append(ifaces, iface)
+	}
+
+	cliDir, err := ioutil.TempDir("", "hostapd_bench")
+	if err != nil {
+		b.Fatal(err)
+	}
+	b.Cleanup(func() { os.RemoveAll(cliDir) })
+
+	m := &socket.Manager{HostapdDir: h.Dir, ClientDir: cliDir}
+	switch *benchEngine {
+	case "cgo":
+	case "reactor":
+		r, err := socket.NewReactor()
+		if err != nil {
+			b.Fatal(err)
+		}
+		b.Cleanup(func() { r.Close() })
+		m.Engine = r
+	case "io_uring":
+		r, err := socket.NewRing()
+		if err != nil {
+			b.Skip("io_uring is unavailable:", err)
+		}
+		b.Cleanup(func() { r.Close() })
+		m.Engine = r
+	default:
+		b.Fatalf("unknown engine %q", *benchEngine)
+	}
+	// Before the engine is closed.
+	b.Cleanup(m.Close)
+
+	svc := &Service{SocketProvider: m, Concurrency: *benchConcurrency}
+	if *benchStationTable {
+		ctx, cancel := context.WithCancel(context.Background())
+		b.Cleanup(cancel)
+		svc.Stations = &StationTable{Sockets: m, ResyncInterval: time.Hour}
+		go svc.Stations.Run(ctx)
+		waitSynced(b, svc.Stations, nSockets)
+	}
+
+	switch *benchTransport {
+	case "bufconn":
+	case "direct":
+		return svc, ifaces
+	default:
+		b.Fatalf("unknown transport %q", *benchTransport)
+	}
+
+	lis := bufconn.Listen(1 << 20)
+	s := grpc.NewServer()
+	hostapd.RegisterHostapdControlServer(s, svc)
+	go s.Serve(lis)
+	b.Cleanup(s.Stop)
+
+	cc, err := grpc.Dial("bufconn",
+		grpc.WithDialer(func(string, time.Duration) (net.Conn, error) {
+			return lis.Dial()
+		}),
+		grpc.WithInsecure())
+	if err != nil {
+		b.Fatal(err)
+	}
+	b.Cleanup(func() { cc.Close() })
+	return grpcClient{hostapd.NewHostapdControlClient(cc)}, ifaces
+}
+
+func waitSynced(b *testing.B, t *StationTable, nSockets int) {
+	deadline := time.Now().Add(time.Minute)
+	for time.Now().Before(deadline) {
+		synced := 0
+		for i := 0; i < nSockets; i++ {
+			if _, ok := t.Clients(fmt.Sprintf("wlan%d", i)); ok {
+				synced++
+			}
+		}
+		if synced == nSockets {
+			return
+		}
+		time.Sleep(10 * time.Millisecond)
+	}
+	b.Fatal("station table never synced")
+}
+
+func requests(ifaces []*fakehostapd.Interface) (n uint64) {
+	for _, iface := range ifaces {
+		n += iface.Requests()
+	}
+	return
+}
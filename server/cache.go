@@ -0,0 +1,67 @@
+package server
+
+import (
+	"sync"
+	"time"
+
+	"github.com/prometheus/client_golang/prometheus"
+)
+
+// The last result of a read from each socket, for requests that accept
+// slightly stale answers. The zero value is ready to use.
+type readCache struct {
+	mu      sync.Mutex
+	entries map[string]cachedRead
+}
+
+type cachedRead struct {
+	at  time.Time // when the read was sent
+	val interface{}
+}
+
+// Returns the cached result for sock if it is no older than maxAge.
+func (c *readCache) get(sock string, maxAge time.Duration) (interface{}, bool) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	e, ok := c.entries[sock]
+	if !ok || time.Since(e.at) > maxAge {
+		return nil, false
+	}
+	return e.val, true
+}
+
+func (c *readCache) put(sock string, at time.Time, val interface{}) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	if c.entries == nil {
+		c.entries = make(map[string]cachedRead)
+	}
+	// A slow read may finish after a newer one.
+	if e, ok := c.entries[sock]; !ok || e.at.Before(at) {
+		c.entries[sock] = cachedRead{at: at, val: val}
+	}
+}
+
+// Counts reads that allowed staleness by RPC and whether the cache answered
+// them. Register it to export it.
+var ResponseCacheRequests = prometheus.NewCounterVec(
+	prometheus.CounterOpts{
+		Name: "hostapd_response_cache_requests_total",
+		Help: "Socket reads that accepted a cached answer, by whether one was fresh enough.",
+	},
+	[]string{"rpc", "result"},
+)
+
+func cacheResult(rpc string, hit bool) {
+	result := "miss"
+	if hit {
+		result = "hit"
+	}
+	ResponseCacheRequests.WithLabelValues(rpc, result).Inc()
+}
+
+func staleness(ms uint32) time.Duration {
+	return time.Duration(ms) * time.Millisecond
+}
@@ -19,9 +19,12 @@ func grpcCodeFromErrno(err syscall.Errno) (c codes.Code) {
 }
 
 func grpcCodeFromRequestError(err *socket.RequestError) (c codes.Code) {
-	if err.Code == socket.DeadlineExceeded {
+	switch err.Code {
+	case socket.DeadlineExceeded:
 		c = codes.DeadlineExceeded
-	} else {
+	case socket.Canceled:
+		c = codes.Canceled
+	default:
 		c = codes.Internal
 	}
 	return
@@ -50,6 +53,10 @@ func reqErrToHostapdErr(rErr *socket.RequestError) *hostapd.SocketError {
 		errno = 0
 	}
 	sErr.Msg = errno.Error()
+	if !ok && rErr.Errno != nil {
+		// Requests abandoned through their context carry the context's error.
+		sErr.Msg = rErr.Errno.Error()
+	}
 	sErr.CErrno = int32(errno)
 	switch rErr.Code {
 	case socket.DeadlineExceeded:
@@ -0,0 +1,82 @@
+package server
+
+import (
+	"context"
+	"sync"
+
+	"go.jonnrb.io/hostapd_grpc/socket"
+)
+
+// Coalesces concurrent calls that would make the same read from hostapd into
+// one whose result every caller gets. The shared call runs under its own
+// context, canceled only once every caller has given up on it, so one caller
+// with a short deadline doesn't fail the rest. The zero value is ready to use.
+type flightGroup struct {
+	mu      sync.Mutex
+	flights map[string]*flight
+}
+
+type flight struct {
+	done    chan struct{}
+	cancel  context.CancelFunc
+	waiters int
+
+	// Set before done is closed.
+	val interface{}
+	err error
+}
+
+func (g *flightGroup) do(ctx context.Context, key string, fn func(context.Context) (interface{}, error)) (interface{}, error) {
+	g.mu.Lock()
+	f, ok := g.flights[key]
+	if !ok {
+		if g.flights == nil {
+			g.flights = make(map[string]*flight)
+		}
+		fctx, cancel := context.WithCancel(context.Background())
+		f = &flight{done: make(chan struct{}), cancel: cancel}
+		g.flights[key] = f
+		go func() {
+			f.val, f.err = fn(fctx)
+			g.forget(key, f)
+			cancel()
+			close(f.done)
+		}()
+	}
+	f.waiters++
+	g.mu.Unlock()
+
+	select {
+	case <-f.done:
+		return f.val, f.err
+	case <-ctx.Done():
+	}
+
+	g.mu.Lock()
+	f.waiters--
+	if f.waiters == 0 {
+		// Later callers start over rather than join a call that's being
+		// canceled.
+		if g.flights[key] == f {
+			delete(g.flights, key)
+		}
+		f.cancel()
+	}
+	g.mu.Unlock()
+
+	// What the request would have failed with had it not been shared.
+	code := socket.Canceled
+	if ctx.Err() == context.DeadlineExceeded {
+		code = socket.DeadlineExceeded
+	}
+	return nil, &socket.RequestError{Errno: ctx.Err(), Code: code}
+}
+
+func (g *flightGroup) forget(key string, f *flight) {
+	g.mu.Lock()
+	defer g.mu.Unlock()
+
+	if g.flights[key] == f {
+		delete(g.flights, key)
+	}
+}
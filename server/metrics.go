@@ -8,6 +8,7 @@ import (
 
 	"github.com/prometheus/client_golang/prometheus"
 	"go.jonnrb.io/hostapd_grpc/proto"
+	"go.jonnrb.io/hostapd_grpc/socket"
 )
 
 type ConnectedClientsGauge struct {
@@ -87,3 +88,102 @@ func (g *ConnectedClientsGauge) Scrape(ctx context.Context, cli hostapd.HostapdC
 	}
 	return sErr.err()
 }
+
+// Exports a socket.Manager's connection cache, pool and breaker stats.
+type SocketCacheCollector struct {
+	Manager *socket.Manager
+}
+
+var (
+	socketCacheHitsDesc = prometheus.NewDesc("hostapd_socket_cache_hits_total",
+		"Socket lookups served by an open connection.", nil, nil)
+	socketCacheMissesDesc = prometheus.NewDesc("hostapd_socket_cache_misses_total",
+		"Socket lookups that had to open a connection.", nil, nil)
+	socketCacheEvictionsDesc = prometheus.NewDesc("hostapd_socket_cache_evictions_total",
+		"Connections closed to stay under the socket limit.", nil, nil)
+	socketCacheSizeDesc = prometheus.NewDesc("hostapd_socket_cache_size",
+		"Hostapd sockets connections are kept open to.", nil, nil)
+	socketPoolSizeDesc = prometheus.NewDesc("hostapd_socket_pool_size",
+		"Most connections opened to one hostapd socket.", nil, nil)
+	socketPoolIdleTimeoutDesc = prometheus.NewDesc("hostapd_socket_pool_idle_timeout_seconds",
+		"How long extra connections to a hostapd socket stay open unused.", nil, nil)
+	socketConnsDesc = prometheus.NewDesc("hostapd_socket_connections",
+		"Connections open to hostapd sockets.", nil, nil)
+	socketConnsInUseDesc = prometheus.NewDesc("hostapd_socket_connections_in_use",
+		"Connections to hostapd sockets with a request on them.", nil, nil)
+	socketConnsOpenedDesc = prometheus.NewDesc("hostapd_socket_connections_opened_total",
+		"Connections opened to hostapd sockets, including reconnects.", nil, nil)
+	socketConnsIdleClosedDesc = prometheus.NewDesc("hostapd_socket_connections_idle_closed_total",
+		"Connections to hostapd sockets closed for being idle.", nil, nil)
+	socketBreakersOpenDesc = prometheus.NewDesc("hostapd_socket_breakers_open",
+		"Hostapd sockets whose requests are failed without trying them.", nil, nil)
+	socketBreakerTripsDesc = prometheus.NewDesc("hostapd_socket_breaker_trips_total",
+		"Times requests to a hostapd socket started being failed without trying them.", nil, nil)
+	socketBreakerRejectionsDesc = prometheus.NewDesc("hostapd_socket_breaker_rejections_total",
+		"Requests to hostapd sockets failed without trying them.", nil, nil)
+)
+
+func (c SocketCacheCollector) Describe(ch chan<- *prometheus.Desc) {
+	ch <- socketCacheHitsDesc
+	ch <- socketCacheMissesDesc
+	ch <- socketCacheEvictionsDesc
+	ch <- socketCacheSizeDesc
+	ch <- socketPoolSizeDesc
+	ch <- socketPoolIdleTimeoutDesc
+	ch <- socketConnsDesc
+	ch <- socketConnsInUseDesc
+	ch <- socketConnsOpenedDesc
+	ch <- socketConnsIdleClosedDesc
+	ch <- socketBreakersOpenDesc
+	ch <- socketBreakerTripsDesc
+	ch <- socketBreakerRejectionsDesc
+}
+
+func (c SocketCacheCollector) Collect(ch chan<- prometheus.Metric) {
+	st := c.Manager.Stats()
+	ch <- prometheus.MustNewConstMetric(socketCacheHitsDesc, prometheus.CounterValue, float64(st.Hits))
+	ch <- prometheus.MustNewConstMetric(socketCacheMissesDesc, prometheus.CounterValue, float64(st.Misses))
+	ch <- prometheus.MustNewConstMetric(socketCacheEvictionsDesc, prometheus.CounterValue, float64(st.Evictions))
+	ch <- prometheus.MustNewConstMetric(socketCacheSizeDesc, prometheus.GaugeValue, float64(st.Cached))
+
+	size := c.Manager.PoolSize
+	if size < 1 {
+		size = 1
+	}
+	ch <- prometheus.MustNewConstMetric(socketPoolSizeDesc, prometheus.GaugeValue, float64(size))
+	ch <- prometheus.MustNewConstMetric(socketPoolIdleTimeoutDesc, prometheus.GaugeValue, c.Manager.PoolIdleTimeout.Seconds())
+	ch <- prometheus.MustNewConstMetric(socketConnsDesc, prometheus.GaugeValue, float64(st.Conns))
+	ch <- prometheus.MustNewConstMetric(socketConnsInUseDesc, prometheus.GaugeValue, float64(st.ConnsInUse))
+	ch <- prometheus.MustNewConstMetric(socketConnsOpenedDesc, prometheus.CounterValue, float64(st.ConnsOpened))
+	ch <- prometheus.MustNewConstMetric(socketConnsIdleClosedDesc, prometheus.CounterValue, float64(st.ConnsClosed))
+	ch <- prometheus.MustNewConstMetric(socketBreakersOpenDesc, prometheus.GaugeValue, float64(st.BreakersOpen))
+	ch <- prometheus.MustNewConstMetric(socketBreakerTripsDesc, prometheus.CounterValue, float64(st.BreakerTrips))
+	ch <- prometheus.MustNewConstMetric(socketBreakerRejectionsDesc, prometheus.CounterValue, float64(st.BreakerRejections))
+}
+
+// Exports the health the socket.Manager's prober last saw of each socket.
+type SocketHealthCollector struct {
+	Manager *socket.Manager
+}
+
+var socketHealthDesc = prometheus.NewDesc("hostapd_socket_health",
+	"1 for the state the prober last saw a hostapd socket in, 0 for the others.",
+	[]string{"socket", "state"}, nil)
+
+var socketHealthStates = []socket.Health{socket.Healthy, socket.Degraded, socket.Dead}
+
+func (c SocketHealthCollector) Describe(ch chan<- *prometheus.Desc) {
+	ch <- socketHealthDesc
+}
+
+func (c SocketHealthCollector) Collect(ch chan<- prometheus.Metric) {
+	for sock, h := range c.Manager.Health() {
+		for _, state := range socketHealthStates {
+			v := 0.0
+			if h == state {
+				v = 1
+			}
+			ch <- prometheus.MustNewConstMetric(socketHealthDesc, prometheus.GaugeValue, v, sock, state.String())
+		}
+	}
+}
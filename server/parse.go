@@ -0,0 +1,219 @@
+package server
+
+import (
+	"bytes"
+	"sync"
+
+	hostapd "go.jonnrb.io/hostapd_grpc/proto"
+)
+
+// Reply buffers for station walks. They are only borrowed while parsing; the
+// parsed clients never point into them.
+var replyPool = sync.Pool{
+	New: func() interface{} {
+		b := make([]byte, 0, 8192)
+		return &b
+	},
+}
+
+// Parses a reply holding any number of stations back to back, each in the
+// format of a STA reply: the address on a line by itself followed by key=value
+// lines.
+//
+// This runs over every station on every walk so it works on the bytes
+// directly. The clients and their flags are carved out of one allocation each
+// and the common flag names are shared strings.
+func parseClients(res []byte, sockName string) []*hostapd.Client {
+	nClis, nFlags := 0, 0
+	for rest := res; len(rest) != 0; {
+		var line []byte
+		line, rest = nextLine(rest)
+		if bytes.IndexByte(line, '=') == -1 {
+			if len(line) != 0 {
+				nClis++
+			}
+		} else {
+			nFlags += bytes.Count(line, []byte{'['})
+		}
+	}
+	if nClis == 0 {
+		return nil
+	}
+
+	var (
+		slab  = make([]hostapd.Client, nClis)
+		clis  = make([]*hostapd.Client, 0, nClis)
+		flags = make([]string, 0, nFlags)
+		cli   *hostapd.Client
+	)
+	for len(res) != 0 {
+		var line []byte
+		line, res = nextLine(res)
+
+		i := bytes.IndexByte(line, '=')
+		switch {
+		case i != -1 && cli != nil:
+			flags = parseCliKV(line[:i], line[i+1:], cli, flags)
+		case i == -1 && len(line) != 0:
+			cli = &slab[len(clis)]
+			cli.Addr = string(line)
+			cli.SocketName = sockName
+			clis = append(clis, cli)
+		}
+	}
+	return clis
+}
+
+// Parses a single STA reply.
+func parseCli(res []byte, sockName string) *hostapd.Client {
+	if clis := parseClients(res, sockName); len(clis) != 0 {
+		return clis[0]
+	}
+	return &hostapd.Client{SocketName: sockName}
+}
+
+func nextLine(b []byte) (line, rest []byte) {
+	if i := bytes.IndexByte(b, '\n'); i != -1 {
+		return b[:i], b[i+1:]
+	}
+	return b, nil
+}
+
+// Fills in the field named k. Flags are appended to the shared flags slice,
+// which is returned.
+func parseCliKV(k, v []byte, cli *hostapd.Client, flags []string) []string {
+	k = trimSpace(k)
+	var lower [16]byte
+	if len(k) <= len(lower) && hasUpper(k) {
+		for i, c := range k {
+			if 'A' <= c && c <= 'Z' {
+				c += 'a' - 'A'
+			}
+			lower[i] = c
+		}
+		k = lower[:len(k)]
+	}
+
+	switch string(k) {
+	case "flags":
+		start := len(flags)
+		flags = parseFlags(v, flags)
+		if len(flags) == start {
+			break
+		}
+		if cli.Flag == nil {
+			cli.Flag = flags[start:len(flags):len(flags)]
+		} else {
+			// More than one flags line; never seen in practice.
+			cli.Flag = append(cli.Flag, flags[start:]...)
+		}
+	case "connected_time":
+		cli.ConnectedTime = parseUint32(v)
+	case "idle_msec":
+		cli.IdleMsec = parseUint32(v)
+	case "rx_packets":
+		cli.RxPackets = parseUint32(v)
+	case "tx_packets":
+		cli.TxPackets = parseUint32(v)
+	case "rx_bytes":
+		cli.RxBytes = parseUint32(v)
+	case "tx_bytes":
+		cli.TxBytes = parseUint32(v)
+	}
+	return flags
+}
+
+// Appends every nonempty name in brackets, like "[AUTH][ASSOC]".
+func parseFlags(v []byte, flags []string) []string {
+	for {
+		i := bytes.IndexByte(v, '[')
+		if i == -1 {
+			return flags
+		}
+		v = v[i+1:]
+		j := bytes.IndexByte(v, ']')
+		if j == -1 {
+			return flags
+		}
+		if j != 0 {
+			flags = append(flags, flagName(v[:j]))
+			v = v[j+1:]
+		}
+	}
+}
+
+// Returns a shared string for the flags hostapd reports for most stations.
+func flagName(b []byte) string {
+	switch string(b) {
+	case "AUTH":
+		return "AUTH"
+	case "ASSOC":
+		return "ASSOC"
+	case "AUTHORIZED":
+		return "AUTHORIZED"
+	case "SHORT_PREAMBLE":
+		return "SHORT_PREAMBLE"
+	case "WMM":
+		return "WMM"
+	case "MFP":
+		return "MFP"
+	case "HT":
+		return "HT"
+	case "VHT":
+		return "VHT"
+	case "HE":
+		return "HE"
+	case "EHT":
+		return "EHT"
+	case "PREAUTH":
+		return "PREAUTH"
+	case "PS":
+		return "PS"
+	case "WDS":
+		return "WDS"
+	}
+	return string(b)
+}
+
+// Values that aren't a uint32 read as zero.
+func parseUint32(b []byte) uint32 {
+	b = trimSpace(b)
+	if len(b) == 0 {
+		// TODO: log error
+		return 0
+	}
+	var u uint64
+	for _, c := range b {
+		if c < '0' || c > '9' {
+			return 0
+		}
+		u = u*10 + uint64(c-'0')
+		if u > 1<<32-1 {
+			return 0
+		}
+	}
+	return uint32(u)
+}
+
+func trimSpace(b []byte) []byte {
+	for len(b) != 0 && isSpace(b[0]) {
+		b = b[1:]
+	}
+	for len(b) != 0 && isSpace(b[len(b)-1]) {
+		b = b[:len(b)-1]
+	}
+	return b
+}
+
+func isSpace(c byte) bool {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'
+}
+
+func hasUpper(b []byte) bool {
+	for _, c := range b {
+		if 'A' <= c && c <= 'Z' {
+			return true
+		}
+	}
+	return false
+}
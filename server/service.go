@@ -1,12 +1,10 @@
 package server
 
 import (
-	"bufio"
 	"context"
 	"log"
-	"regexp"
-	"strconv"
-	"strings"
+	"sync"
+	"time"
 
 	hostapd "go.jonnrb.io/hostapd_grpc/proto"
 	"go.jonnrb.io/hostapd_grpc/socket"
@@ -21,6 +19,22 @@ type SocketProvider interface {
 
 type Service struct {
 	SocketProvider
+
+	// If set, ListClients is answered from memory for every socket the table is
+	// tracking instead of walking the stations on hostapd.
+	Stations *StationTable
+
+	// How many sockets a single Ping or ListClients talks to at once. Zero
+	// means all of them.
+	Concurrency int
+
+	// Concurrent identical reads of a socket share one round trip.
+	pings, walks flightGroup
+
+	// The last successful reads, for requests that accept stale answers.
+	pingCache, walkCache readCache
+
+	allSta allStaSupport
 }
 
 func (s *Service) ListSockets(ctx context.Context, _ *hostapd.ListSocketsRequest) (*hostapd.SocketList, error) {
@@ -52,28 +66,61 @@ func (s *Service) getSockets(i socketGetter) ([]string, error) {
 	return sockets, nil
 }
 
-func (s *Service) pingSocket(ctx context.Context, sockName string) (*hostapd.Pong, error) {
-	sock, err := s.Get(sockName)
+// Concurrent pings of the same socket share one PING. Only successful pings are
+// cached.
+func (s *Service) pingSocket(ctx context.Context, sockName string, maxStaleness time.Duration) (*hostapd.Pong, error) {
+	pong := &hostapd.Pong{SocketName: sockName}
+	if maxStaleness > 0 {
+		_, hit := s.pingCache.get(sockName, maxStaleness)
+		cacheResult("Ping", hit)
+		if hit {
+			return pong, nil
+		}
+	}
+
+	_, err := s.pings.do(ctx, sockName, func(ctx context.Context) (interface{}, error) {
+		at := time.Now()
+		err := ping(ctx, s.SocketProvider, sockName)
+		if err == nil {
+			s.pingCache.put(sockName, at, nil)
+		}
+		return nil, err
+	})
+	if rErr, ok := err.(*socket.RequestError); ok {
+		pong.Error = reqErrToHostapdErr(rErr)
+		return pong, nil
+	} else if err != nil {
+		return nil, err
+	}
+	return pong, nil
+}
+
+// Returns request errors as is and anything else as a status.
+func ping(ctx context.Context, sockets SocketProvider, sockName string) error {
+	sock, err := sockets.Get(sockName)
 	if err != nil {
-		return nil, errToStatus(err).Err()
+		// Including sockets known to be dead, which shouldn't fail the whole
+		// RPC.
+		if _, ok := err.(*socket.RequestError); ok {
+			return err
+		}
+		return errToStatus(err).Err()
 	}
 	defer sock.Close()
 
-	pong := &hostapd.Pong{SocketName: sockName}
-	res, err := sock.SendRawCmd("PING")
+	var buf [16]byte
+	res, err := sock.AppendRawCmd(ctx, buf[:0], "PING")
 	if err != nil {
-		if rErr, ok := err.(*socket.RequestError); ok {
-			pong.Error = reqErrToHostapdErr(rErr)
-			return pong, nil
-		} else {
-			return nil, errToStatus(err).Err()
+		if _, ok := err.(*socket.RequestError); ok {
+			return err
 		}
+		return errToStatus(err).Err()
 	}
 
-	if res != "PONG\n" {
-		return nil, status.Errorf(codes.Internal, "bad response: %v", res)
+	if string(res) != "PONG\n" {
+		return status.Errorf(codes.Internal, "bad response: %s", res)
 	}
-	return pong, nil
+	return nil
 }
 
 func (s *Service) Ping(ctx context.Context, req *hostapd.PingRequest) (*hostapd.PongResponse, error) {
@@ -83,94 +130,122 @@ func (s *Service) Ping(ctx context.Context, req *hostapd.PingRequest) (*hostapd.
 		return nil, err
 	}
 
-	res := &hostapd.PongResponse{}
-	for _, sockName := range sockets {
-		pong, err := s.pingSocket(ctx, sockName)
+	pongs := make([]*hostapd.Pong, len(sockets))
+	errs := make([]error, len(sockets))
+	fanOut(len(sockets), s.Concurrency, func(i int) {
+		pongs[i], errs[i] = s.pingSocket(ctx, sockets[i], staleness(req.GetMaxStalenessMs()))
+	})
+
+	for i, err := range errs {
 		if err != nil {
-			log.Printf("Error pinging %q: %v", sockName, err)
+			log.Printf("Error pinging %q: %v", sockets[i], err)
 			return nil, err
 		}
-		res.Pong = append(res.Pong, pong)
 	}
-	return res, nil
+	return &hostapd.PongResponse{Pong: pongs}, nil
+}
+
+// Remembers the sockets that answered ALL_STA with an error so that walks of
+// them don't ask every time. Stock hostapd doesn't understand it; builds that
+// do answer with every station in one reply. An answer only holds for the
+// socket Get returned when it was given, which is replaced when hostapd's
+// socket goes away or is found dead, and for allStaRecheck, since hostapd may
+// be restarted or upgraded under the same name. The zero value is ready to
+// use.
+type allStaSupport struct {
+	mu sync.Mutex
+	no map[string]noAllSta
+}
+
+type noAllSta struct {
+	sock socket.Socket
+	at   time.Time
 }
 
-var flagsRe = regexp.MustCompile(`\[([^\]]+)\]`)
+const allStaRecheck = 10 * time.Minute
 
-func parseUint32(s string) uint32 {
-	u, err := strconv.ParseUint(s, 10, 32)
-	if err != nil {
-		// TODO: log error
-		return 0
+func (a *allStaSupport) unsupported(sockName string, sock socket.Socket) bool {
+	a.mu.Lock()
+	defer a.mu.Unlock()
+
+	e, ok := a.no[sockName]
+	if !ok {
+		return false
+	}
+	if e.sock != sock || time.Since(e.at) > allStaRecheck {
+		delete(a.no, sockName)
+		return false
 	}
-	return uint32(u)
+	return true
 }
 
-func parseCliKV(k, v string, cli *hostapd.Client) {
-	switch strings.ToLower(strings.TrimSpace(k)) {
-	case "flags":
-		flags := flagsRe.FindAllStringSubmatch(v, -1)
-		for _, m := range flags {
-			cli.Flag = append(cli.Flag, m[1])
-		}
-	case "connected_time":
-		cli.ConnectedTime = parseUint32(strings.TrimSpace(v))
-	case "idle_msec":
-		cli.IdleMsec = parseUint32(strings.TrimSpace(v))
-	case "rx_packets":
-		cli.RxPackets = parseUint32(strings.TrimSpace(v))
-	case "tx_packets":
-		cli.TxPackets = parseUint32(strings.TrimSpace(v))
-	case "rx_bytes":
-		cli.RxBytes = parseUint32(strings.TrimSpace(v))
-	case "tx_bytes":
-		cli.TxBytes = parseUint32(strings.TrimSpace(v))
-	}
-}
-
-func parseCli(tok string) *hostapd.Client {
-	s := bufio.NewScanner(strings.NewReader(tok))
-	haveAddr := false
-	ret := &hostapd.Client{}
-	for s.Scan() {
-		if !haveAddr {
-			ret.Addr = s.Text()
-			haveAddr = true
-			continue
-		}
+func (a *allStaSupport) setUnsupported(sockName string, sock socket.Socket) {
+	a.mu.Lock()
+	defer a.mu.Unlock()
 
-		m := strings.SplitN(s.Text(), "=", 2)
-		if len(m) != 2 {
-			// TODO: log
-			continue
-		}
-		parseCliKV(m[0], m[1], ret)
+	if a.no == nil {
+		a.no = make(map[string]noAllSta)
 	}
-	return ret
+	a.no[sockName] = noAllSta{sock: sock, at: time.Now()}
 }
 
-func (s *Service) listClientsOnSock(ctx context.Context, sockName string) ([]*hostapd.Client, error) {
-	sock, err := s.Get(sockName)
+func walkClients(ctx context.Context, sockets SocketProvider, allSta *allStaSupport, sockName string) ([]*hostapd.Client, error) {
+	sock, err := sockets.Get(sockName)
 	if err != nil {
 		return nil, err
 	}
+	defer sock.Close()
+
+	buf := replyPool.Get().(*[]byte)
+	defer replyPool.Put(buf)
+
+	if !allSta.unsupported(sockName, sock) {
+		*buf, err = sock.AppendRawCmd(ctx, (*buf)[:0], "ALL_STA")
+		if err != nil {
+			return nil, err
+		}
+		if string(*buf) != "UNKNOWN COMMAND\n" && string(*buf) != "FAIL\n" {
+			return parseClients(*buf, sockName), nil
+		}
+		allSta.setUnsupported(sockName, sock)
+	}
 
-	tok, err := sock.SendRawCmd("STA-FIRST")
+	*buf, err = sock.AppendStations(ctx, (*buf)[:0])
 	if err != nil {
 		return nil, err
 	}
-	var clis []*hostapd.Client
-	for tok != "" && tok != "FAIL\n" {
-		cli := parseCli(tok)
-		cli.SocketName = sockName
-		clis = append(clis, cli)
+	return parseClients(*buf, sockName), nil
+}
 
-		tok, err = sock.SendRawCmd("STA-NEXT " + cli.Addr)
-		if err != nil {
-			return nil, err
+func (s *Service) listClientsOnSock(ctx context.Context, sockName string, maxStaleness time.Duration) ([]*hostapd.Client, error) {
+	if s.Stations != nil {
+		if clis, ok := s.Stations.Clients(sockName); ok {
+			return clis, nil
+		}
+	}
+	if maxStaleness > 0 {
+		clis, hit := s.walkCache.get(sockName, maxStaleness)
+		cacheResult("ListClients", hit)
+		if hit {
+			return clis.([]*hostapd.Client), nil
+		}
+	}
+
+	// Concurrent lists of the same socket share one walk. The clients are
+	// never mutated once parsed, so every response (and the cache) can hold
+	// them.
+	clis, err := s.walks.do(ctx, sockName, func(ctx context.Context) (interface{}, error) {
+		at := time.Now()
+		clis, err := walkClients(ctx, s.SocketProvider, &s.allSta, sockName)
+		if err == nil {
+			s.walkCache.put(sockName, at, clis)
 		}
+		return clis, err
+	})
+	if err != nil {
+		return nil, err
 	}
-	return clis, nil
+	return clis.([]*hostapd.Client), nil
 }
 
 func (s *Service) ListClients(ctx context.Context, req *hostapd.ListClientsRequest) (*hostapd.ListClientsResponse, error) {
@@ -179,9 +254,15 @@ func (s *Service) ListClients(ctx context.Context, req *hostapd.ListClientsReque
 		return nil, err
 	}
 
+	clisBySock := make([][]*hostapd.Client, len(sockets))
+	errs := make([]error, len(sockets))
+	fanOut(len(sockets), s.Concurrency, func(i int) {
+		clisBySock[i], errs[i] = s.listClientsOnSock(ctx, sockets[i], staleness(req.GetMaxStalenessMs()))
+	})
+
 	res := &hostapd.ListClientsResponse{}
-	for _, sockName := range sockets {
-		clis, err := s.listClientsOnSock(ctx, sockName)
+	for i, sockName := range sockets {
+		clis, err := clisBySock[i], errs[i]
 		switch err := err.(type) {
 		case *socket.RequestError:
 			log.Printf("RequestError for ListClients on %q: %v", sockName, err)
@@ -195,3 +276,39 @@ func (s *Service) ListClients(ctx context.Context, req *hostapd.ListClientsReque
 	}
 	return res, nil
 }
+
+func (s *Service) WatchClients(req *hostapd.WatchClientsRequest, stream hostapd.HostapdControl_WatchClientsServer) error {
+	if s.Stations == nil {
+		return status.Error(codes.Unimplemented, "station table is not enabled")
+	}
+
+	snapshot, synced, w := s.Stations.watch(req.GetSocketName())
+	defer s.Stations.unwatch(w)
+
+	for _, cli := range snapshot {
+		ev := &hostapd.ClientEvent{Type: hostapd.ClientEvent_EXISTING, Client: cli}
+		if err := stream.Send(ev); err != nil {
+			return err
+		}
+	}
+	if synced {
+		if err := stream.Send(&hostapd.ClientEvent{Type: hostapd.ClientEvent_SYNCED}); err != nil {
+			return err
+		}
+	}
+	// Otherwise the rest of the snapshot and SYNCED come through w.events.
+
+	ctx := stream.Context()
+	for {
+		select {
+		case ev := <-w.events:
+			if err := stream.Send(ev); err != nil {
+				return err
+			}
+		case <-w.overflow:
+			return status.Error(codes.ResourceExhausted, "client events were dropped; watch again")
+		case <-ctx.Done():
+			return ctx.Err()
+		}
+	}
+}
@@ -0,0 +1,144 @@
+package server
+
+import (
+	"context"
+	"fmt"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"testing"
+	"time"
+
+	"go.jonnrb.io/hostapd_grpc/fakehostapd"
+	"go.jonnrb.io/hostapd_grpc/socket"
+)
+
+func TestMain(m *testing.M) {
+	fakehostapd.ServeChild()
+	os.Exit(m.Run())
+}
+
+// Hands out the same socket until told otherwise.
+type fixedSockets struct {
+	sock socket.Socket
+}
+
+type nopClose struct{ socket.Socket }
+
+func (nopClose) Close() error { return nil }
+
+func (p *fixedSockets) Get(string) (socket.Socket, error) { return nopClose{p.sock}, nil }
+func (p *fixedSockets) Available() ([]string, error)      { return []string{"wlan0"}, nil }
+
+func TestWalkClientsRechecksAllSta(t *testing.T) {
+	h, err := fakehostapd.New("")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer h.Close()
+	iface, err := h.AddInterface("wlan0", fakehostapd.Options{Stations: 3})
+	if err != nil {
+		t.Fatal(err)
+	}
+	clientDir, err := ioutil.TempDir("", "hostapd_grpc")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(clientDir)
+
+	open := func() socket.Socket {
+		s, err := socket.Open(filepath.Join(h.Dir, "wlan0"), clientDir)
+		if err != nil {
+			t.Fatal(err)
+		}
+		return s
+	}
+	first := open()
+	defer first.Close()
+	p := &fixedSockets{sock: first}
+
+	var allSta allStaSupport
+	// ALL_STA and then STA-FIRST, STA-NEXT for each station.
+	const (
+		withAllSta    = 5
+		withoutAllSta = 4
+	)
+	walk := func(want uint64) {
+		t.Helper()
+		before := iface.Requests()
+		clis, err := walkClients(context.Background(), p, &allSta, "wlan0")
+		if err != nil {
+			t.Fatal(err)
+		}
+		if len(clis) != 3 {
+			t.Fatalf("got %d clients; want 3", len(clis))
+		}
+		if got := iface.Requests() - before; got != want {
+			t.Errorf("walk sent %d requests; want %d", got, want)
+		}
+	}
+
+	walk(withAllSta)
+	walk(withoutAllSta)
+
+	// A new socket may be a new hostapd.
+	second := open()
+	defer second.Close()
+	p.sock = second
+	walk(withAllSta)
+	walk(withoutAllSta)
+
+	// So may an old answer.
+	allSta.mu.Lock()
+	e := allSta.no["wlan0"]
+	e.at = e.at.Add(-allStaRecheck - time.Second)
+	allSta.no["wlan0"] = e
+	allSta.mu.Unlock()
+	walk(withAllSta)
+}
+
+// Counts what listing the clients on one socket costs the server: the request,
+// parsing the reply and building the protos. The fake runs in another process
+// so that its allocations don't count.
+func BenchmarkListClientsOnSock(b *testing.B) {
+	for _, allSta := range []bool{false, true} {
+		for _, stations := range []int{10, 100} {
+			b.Run(fmt.Sprintf("all_sta=%v/stations=%d", allSta, stations), func(b *testing.B) {
+				dir, err := ioutil.TempDir("", "fakehostapd")
+				if err != nil {
+					b.Fatal(err)
+				}
+				defer os.RemoveAll(dir)
+				stop, err := fakehostapd.StartChild(dir, 1, fakehostapd.Options{Stations: stations, AllSta: allSta})
+				if err != nil {
+					b.Fatal(err)
+				}
+				defer stop()
+				clientDir, err := ioutil.TempDir("", "hostapd_grpc")
+				if err != nil {
+					b.Fatal(err)
+				}
+				defer os.RemoveAll(clientDir)
+
+				s := &Service{SocketProvider: &socket.Manager{HostapdDir: dir, ClientDir: clientDir}}
+				ctx := context.Background()
+				// Connects and learns whether ALL_STA works.
+				if _, err := s.listClientsOnSock(ctx, "wlan0", 0); err != nil {
+					b.Fatal(err)
+				}
+
+				b.ReportAllocs()
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					clis, err := s.listClientsOnSock(ctx, "wlan0", 0)
+					if err != nil {
+						b.Fatal(err)
+					}
+					if len(clis) != stations {
+						b.Fatalf("got %d clients; want %d", len(clis), stations)
+					}
+				}
+			})
+		}
+	}
+}
@@ -0,0 +1,455 @@
+package server
+
+import (
+	"context"
+	"log"
+	"sort"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/golang/protobuf/proto"
+	hostapd "go.jonnrb.io/hostapd_grpc/proto"
+	"go.jonnrb.io/hostapd_grpc/socket"
+)
+
+type MonitorProvider interface {
+	SocketProvider
+	Attach(socket string) (socket.Monitor, error)
+}
+
+// StationTable keeps an in-memory list of the stations associated with each
+// hostapd socket. It is fed by AP-STA-CONNECTED and AP-STA-DISCONNECTED events
+// from an attached monitor connection, so reading it never costs a round trip
+// to hostapd. Every socket is also fully walked every ResyncInterval in case
+// events were missed.
+type StationTable struct {
+	Sockets        MonitorProvider
+	ResyncInterval time.Duration
+
+	mu       sync.RWMutex
+	socks    map[string]*stationSet
+	watchers map[*stationWatcher]struct{}
+
+	allSta allStaSupport
+}
+
+type stationSet struct {
+	// nil if the monitor failed; the next resync attaches again.
+	mon socket.Monitor
+
+	// Client entries are never mutated once stored so that they can be handed
+	// out to concurrent readers.
+	clients map[string]*hostapd.Client
+	synced  bool
+
+	// Stations that had events while a full walk was in flight. The walk result
+	// is older than these so it must not clobber them.
+	touched map[string]struct{}
+}
+
+// A subscription to station changes. Events are dropped on the floor if the
+// subscriber can't keep up; overflow is closed when that happens and the
+// subscriber has to start over.
+type stationWatcher struct {
+	sockets  map[string]struct{} // nil means all sockets
+	events   chan *hostapd.ClientEvent
+	overflow chan struct{}
+
+	// Sockets that weren't synced when the subscription started. Their
+	// stations are sent as EXISTING once they are, and SYNCED follows the last
+	// of them. Guarded by the table's mu.
+	pending map[string]struct{}
+}
+
+const (
+	defaultResyncInterval = time.Minute
+	watcherBacklog        = 256
+)
+
+// Returns the stations on sock. ok is false if the socket isn't being tracked
+// (yet), in which case the caller has to ask hostapd directly.
+func (t *StationTable) Clients(sock string) (clis []*hostapd.Client, ok bool) {
+	t.mu.RLock()
+	defer t.mu.RUnlock()
+
+	set, ok := t.socks[sock]
+	if !ok || !set.synced {
+		return nil, false
+	}
+	return set.list(), true
+}
+
+func (set *stationSet) list() []*hostapd.Client {
+	clis := make([]*hostapd.Client, 0, len(set.clients))
+	for _, cli := range set.clients {
+		clis = append(clis, cli)
+	}
+	sort.Slice(clis, func(i, j int) bool { return clis[i].Addr < clis[j].Addr })
+	return clis
+}
+
+// Subscribes to changes on the named sockets (or all of them if there are
+// none). The stations already known are returned atomically with the
+// subscription so nothing falls in between. Sockets that are still being walked
+// or whose monitor failed are left out of the snapshot; if there are any,
+// synced is false and the watcher delivers their stations followed by SYNCED
+// once they have been walked. The caller must unwatch the returned watcher when
+// done.
+func (t *StationTable) watch(sockets []string) (snapshot []*hostapd.Client, synced bool, w *stationWatcher) {
+	w = &stationWatcher{
+		events:   make(chan *hostapd.ClientEvent, watcherBacklog),
+		overflow: make(chan struct{}),
+		pending:  make(map[string]struct{}),
+	}
+	if len(sockets) != 0 {
+		w.sockets = make(map[string]struct{}, len(sockets))
+		for _, name := range sockets {
+			w.sockets[name] = struct{}{}
+		}
+	}
+
+	t.mu.Lock()
+	defer t.mu.Unlock()
+
+	if t.watchers == nil {
+		t.watchers = make(map[*stationWatcher]struct{})
+	}
+	t.watchers[w] = struct{}{}
+
+	for name, set := range t.socks {
+		switch {
+		case !w.wants(name):
+		case set.synced:
+			snapshot = append(snapshot, set.list()...)
+		default:
+			w.pending[name] = struct{}{}
+		}
+	}
+	return snapshot, len(w.pending) == 0, w
+}
+
+func (t *StationTable) unwatch(w *stationWatcher) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+
+	delete(t.watchers, w)
+}
+
+func (w *stationWatcher) wants(sock string) bool {
+	if w.sockets == nil {
+		return true
+	}
+	_, ok := w.sockets[sock]
+	return ok
+}
+
+// t.mu must be held.
+func (t *StationTable) publish(sock string, typ hostapd.ClientEvent_Type, cli *hostapd.Client) {
+	ev := &hostapd.ClientEvent{Type: typ, Client: cli}
+	for w := range t.watchers {
+		if _, pending := w.pending[sock]; w.wants(sock) && !pending {
+			t.send(w, ev)
+		}
+	}
+}
+
+// Hands the stations on a socket that has just been walked to the watchers
+// waiting for it. set is nil if the socket went away instead. t.mu must be
+// held.
+func (t *StationTable) release(sock string, set *stationSet) {
+	var clis []*hostapd.Client
+	if set != nil {
+		clis = set.list()
+	}
+	for w := range t.watchers {
+		if _, ok := w.pending[sock]; !ok {
+			continue
+		}
+		delete(w.pending, sock)
+		t.catchUp(w, clis)
+	}
+}
+
+// t.mu must be held.
+func (t *StationTable) catchUp(w *stationWatcher, clis []*hostapd.Client) {
+	for _, cli := range clis {
+		if !t.send(w, &hostapd.ClientEvent{Type: hostapd.ClientEvent_EXISTING, Client: cli}) {
+			return
+		}
+	}
+	if len(w.pending) == 0 {
+		t.send(w, &hostapd.ClientEvent{Type: hostapd.ClientEvent_SYNCED})
+	}
+}
+
+// Returns false if w couldn't keep up and has been dropped. t.mu must be held.
+func (t *StationTable) send(w *stationWatcher, ev *hostapd.ClientEvent) bool {
+	select {
+	case w.events <- ev:
+		return true
+	default:
+		close(w.overflow)
+		delete(t.watchers, w)
+		return false
+	}
+}
+
+// Runs until ctx is done.
+func (t *StationTable) Run(ctx context.Context) {
+	interval := t.ResyncInterval
+	if interval <= 0 {
+		interval = defaultResyncInterval
+	}
+
+	tick := time.NewTicker(interval)
+	defer tick.Stop()
+	defer t.closeAll()
+	for {
+		t.resync(ctx)
+
+		select {
+		case <-tick.C:
+		case <-ctx.Done():
+			return
+		}
+	}
+}
+
+func (t *StationTable) closeAll() {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+
+	for name, set := range t.socks {
+		t.remove(name, set)
+	}
+}
+
+// t.mu must be held.
+func (t *StationTable) remove(name string, set *stationSet) {
+	if set.mon != nil {
+		set.mon.Close()
+	}
+	for _, cli := range set.list() {
+		t.publish(name, hostapd.ClientEvent_DISCONNECTED, cli)
+	}
+	delete(t.socks, name)
+	t.release(name, nil)
+}
+
+func (t *StationTable) resync(ctx context.Context) {
+	sockets, err := t.Sockets.Available()
+	if err != nil {
+		log.Println("Error listing sockets for station table:", err)
+		return
+	}
+
+	present := make(map[string]struct{}, len(sockets))
+	for _, name := range sockets {
+		present[name] = struct{}{}
+	}
+
+	t.mu.Lock()
+	if t.socks == nil {
+		t.socks = make(map[string]*stationSet)
+	}
+	for name, set := range t.socks {
+		if _, ok := present[name]; !ok {
+			t.remove(name, set)
+		}
+	}
+	t.mu.Unlock()
+
+	for _, name := range sockets {
+		if ctx.Err() != nil {
+			return
+		}
+		if err := t.resyncSocket(ctx, name); err != nil {
+			log.Printf("Error syncing stations on %q: %v", name, err)
+		}
+	}
+}
+
+func (t *StationTable) resyncSocket(ctx context.Context, name string) error {
+	t.mu.Lock()
+	set, ok := t.socks[name]
+	if !ok {
+		set = &stationSet{clients: make(map[string]*hostapd.Client)}
+		t.socks[name] = set
+	}
+	attached := set.mon != nil
+	t.mu.Unlock()
+
+	var mon socket.Monitor
+	if !attached {
+		// Attach before walking so that nothing that happens during the walk is
+		// missed. Attaching talks to hostapd, so it's done without t.mu held;
+		// only Run's goroutine attaches, so nothing else can race to do it.
+		var err error
+		if mon, err = t.Sockets.Attach(name); err != nil {
+			return err
+		}
+	}
+
+	t.mu.Lock()
+	if t.socks[name] != set {
+		// Removed while attaching.
+		t.mu.Unlock()
+		if mon != nil {
+			mon.Close()
+		}
+		return nil
+	}
+	if mon != nil {
+		set.mon = mon
+		go t.watchMonitor(ctx, name, set, mon)
+	}
+	set.touched = make(map[string]struct{})
+	t.mu.Unlock()
+
+	clis, err := walkClients(ctx, t.Sockets, &t.allSta, name)
+	if err != nil {
+		return err
+	}
+
+	t.mu.Lock()
+	defer t.mu.Unlock()
+
+	if t.socks[name] != set || set.mon == nil {
+		// Removed or the monitor died while walking.
+		return nil
+	}
+	next := make(map[string]*hostapd.Client, len(clis))
+	for _, cli := range clis {
+		if _, ok := set.touched[cli.Addr]; !ok {
+			next[cli.Addr] = cli
+		}
+	}
+	for addr := range set.touched {
+		if cli, ok := set.clients[addr]; ok {
+			next[addr] = cli
+		}
+	}
+
+	for addr, cli := range set.clients {
+		if _, ok := next[addr]; !ok {
+			t.publish(name, hostapd.ClientEvent_DISCONNECTED, cli)
+		}
+	}
+	for addr, cli := range next {
+		if prev, ok := set.clients[addr]; !ok {
+			t.publish(name, hostapd.ClientEvent_CONNECTED, cli)
+		} else if prev != cli && !proto.Equal(prev, cli) {
+			t.publish(name, hostapd.ClientEvent_UPDATED, cli)
+		}
+	}
+
+	set.clients = next
+	set.touched = nil
+	set.synced = true
+	t.release(name, set)
+	return nil
+}
+
+func (t *StationTable) watchMonitor(ctx context.Context, name string, set *stationSet, mon socket.Monitor) {
+	for {
+		msg, err := mon.Recv()
+		if err != nil {
+			t.drop(name, set, mon, err)
+			return
+		}
+
+		event, addr := parseStaEvent(msg)
+		switch event {
+		case socket.StaConnected:
+			cli, err := fetchClient(ctx, t.Sockets, name, addr)
+			if err != nil {
+				log.Printf("Error fetching station %v on %q: %v", addr, name, err)
+				continue
+			}
+			t.update(name, set, addr, cli)
+		case socket.StaDisconnected:
+			t.update(name, set, addr, nil)
+		}
+	}
+}
+
+// Stores cli as the state of addr. A nil cli removes the station.
+func (t *StationTable) update(name string, set *stationSet, addr string, cli *hostapd.Client) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+
+	if t.socks[name] != set {
+		return
+	}
+	if set.touched != nil {
+		set.touched[addr] = struct{}{}
+	}
+
+	prev, ok := set.clients[addr]
+	if cli != nil {
+		set.clients[addr] = cli
+		if ok {
+			t.publish(name, hostapd.ClientEvent_UPDATED, cli)
+		} else {
+			t.publish(name, hostapd.ClientEvent_CONNECTED, cli)
+		}
+	} else if ok {
+		delete(set.clients, addr)
+		t.publish(name, hostapd.ClientEvent_DISCONNECTED, prev)
+	}
+}
+
+// Marks a socket whose monitor has failed as out of sync. Reads fall back to
+// asking hostapd until the next resync attaches again; the stations are kept
+// so that the resync only reports what actually changed.
+func (t *StationTable) drop(name string, set *stationSet, mon socket.Monitor, err error) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+
+	if t.socks[name] != set || set.mon != mon {
+		// Already closed by resync or closeAll.
+		return
+	}
+	log.Printf("Station monitor on %q failed: %v", name, err)
+	mon.Close()
+	set.mon = nil
+	set.synced = false
+}
+
+// Parses an unsolicited hostapd message like
+// "<3>AP-STA-CONNECTED 02:00:00:00:01:00 keyid=foo".
+func parseStaEvent(msg string) (event, addr string) {
+	if strings.HasPrefix(msg, "<") {
+		if i := strings.IndexByte(msg, '>'); i != -1 {
+			msg = msg[i+1:]
+		}
+	}
+
+	f := strings.Fields(msg)
+	if len(f) < 2 {
+		return "", ""
+	}
+	return f[0], f[1]
+}
+
+func fetchClient(ctx context.Context, sockets SocketProvider, sockName, addr string) (*hostapd.Client, error) {
+	sock, err := sockets.Get(sockName)
+	if err != nil {
+		return nil, err
+	}
+	defer sock.Close()
+
+	buf := replyPool.Get().(*[]byte)
+	defer replyPool.Put(buf)
+
+	*buf, err = sock.AppendRawCmd(ctx, (*buf)[:0], "STA "+addr)
+	if err != nil {
+		return nil, err
+	}
+	if len(*buf) == 0 || string(*buf) == "FAIL\n" {
+		// Gone again already.
+		return nil, nil
+	}
+	return parseCli(*buf, sockName), nil
+}
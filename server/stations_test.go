@@ -0,0 +1,74 @@
+package server
+
+import (
+	"context"
+	"io/ioutil"
+	"os"
+	"testing"
+
+	"go.jonnrb.io/hostapd_grpc/fakehostapd"
+	hostapd "go.jonnrb.io/hostapd_grpc/proto"
+	"go.jonnrb.io/hostapd_grpc/socket"
+)
+
+func TestWatchWaitsForUnsyncedSockets(t *testing.T) {
+	h, err := fakehostapd.New("")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer h.Close()
+	iface, err := h.AddInterface("wlan0", fakehostapd.Options{Stations: 3})
+	if err != nil {
+		t.Fatal(err)
+	}
+	clientDir, err := ioutil.TempDir("", "hostapd_grpc")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(clientDir)
+
+	// wlan0's monitor failed after it had seen a station that has since left.
+	stale := &hostapd.Client{Addr: "02:00:00:00:ff:ff", SocketName: "wlan0"}
+	table := &StationTable{
+		Sockets: &socket.Manager{HostapdDir: h.Dir, ClientDir: clientDir},
+		socks: map[string]*stationSet{
+			"wlan0": {clients: map[string]*hostapd.Client{stale.Addr: stale}},
+		},
+	}
+	defer table.closeAll()
+
+	snapshot, synced, w := table.watch(nil)
+	defer table.unwatch(w)
+	if len(snapshot) != 0 || synced {
+		t.Fatalf("got snapshot %v, synced %v; want nothing until wlan0 is walked", snapshot, synced)
+	}
+	select {
+	case ev := <-w.events:
+		t.Fatalf("got %v before wlan0 was walked", ev)
+	default:
+	}
+
+	if err := table.resyncSocket(context.Background(), "wlan0"); err != nil {
+		t.Fatal(err)
+	}
+	want := iface.Stations()
+	for i := 0; i <= len(want); i++ {
+		var ev *hostapd.ClientEvent
+		select {
+		case ev = <-w.events:
+		default:
+			t.Fatalf("got %d events; want %d stations and SYNCED", i, len(want))
+		}
+		switch {
+		case i < len(want) && (ev.Type != hostapd.ClientEvent_EXISTING || ev.Client.Addr != want[i]):
+			t.Errorf("event %d: got %v; want EXISTING %v", i, ev, want[i])
+		case i == len(want) && ev.Type != hostapd.ClientEvent_SYNCED:
+			t.Errorf("event %d: got %v; want SYNCED", i, ev)
+		}
+	}
+	select {
+	case ev := <-w.events:
+		t.Errorf("got %v after SYNCED", ev)
+	default:
+	}
+}
@@ -2,6 +2,7 @@ package server
 
 import (
 	"context"
+	"sync"
 
 	hostapd "go.jonnrb.io/hostapd_grpc/proto"
 )
@@ -28,3 +29,26 @@ func listClients(ctx context.Context, cli hostapd.HostapdControlServer, socket s
 	}
 	return res.Client, nil
 }
+
+// Runs f(0) through f(n-1) concurrently, with at most limit of them running at
+// a time, and waits for all of them. limit <= 0 means no limit.
+func fanOut(n, limit int, f func(i int)) {
+	if limit <= 0 || limit > n {
+		limit = n
+	}
+
+	var wg sync.WaitGroup
+	sem := make(chan struct{}, limit)
+	for i := 0; i < n; i++ {
+		sem <- struct{}{}
+		wg.Add(1)
+		go func(i int) {
+			defer func() {
+				<-sem
+				wg.Done()
+			}()
+			f(i)
+		}(i)
+	}
+	wg.Wait()
+}
@@ -0,0 +1,110 @@
+package socket
+
+import (
+	"sync"
+	"time"
+)
+
+// Stops a sharedSocket from reconnecting on every request while hostapd is
+// down. After threshold failures in a row (reconnects that fail or requests
+// on dead connections) the breaker opens and requests fail with the last error,
+// as a RequestError, without touching the socket. Once cooldown has passed, a
+// single request is let through to test it (half-open); if it works the
+// breaker closes, and if not it opens for another cooldown.
+type breaker struct {
+	threshold int // zero disables the breaker
+	cooldown  time.Duration
+
+	mu       sync.Mutex
+	state    breakerState
+	failures int
+	openedAt time.Time
+	err      error
+
+	trips, rejected uint64
+}
+
+type breakerState int
+
+const (
+	breakerClosed breakerState = iota
+	breakerOpen
+	breakerHalfOpen
+)
+
+// What a request showed about the connection.
+type breakerResult int
+
+const (
+	// Didn't get far enough to tell, e.g. it gave up waiting.
+	breakerUnknown breakerResult = iota
+	breakerSuccess
+	breakerFailure
+)
+
+// Returns the error to fail with if the request can't go through. trial is set
+// for the one request let through when half-open, which must be reported to
+// record.
+func (b *breaker) allow() (trial bool, err error) {
+	if b.threshold <= 0 {
+		return false, nil
+	}
+
+	b.mu.Lock()
+	defer b.mu.Unlock()
+
+	switch b.state {
+	case breakerOpen:
+		if time.Since(b.openedAt) >= b.cooldown {
+			b.state = breakerHalfOpen
+			return true, nil
+		}
+		fallthrough
+	case breakerHalfOpen:
+		b.rejected++
+		return false, b.err
+	default:
+		return false, nil
+	}
+}
+
+func (b *breaker) record(trial bool, res breakerResult, err error) {
+	if b.threshold <= 0 {
+		return
+	}
+
+	b.mu.Lock()
+	defer b.mu.Unlock()
+
+	switch res {
+	case breakerSuccess:
+		b.failures = 0
+		b.state = breakerClosed
+	case breakerFailure:
+		b.failures++
+		if trial || (b.state == breakerClosed && b.failures >= b.threshold) {
+			b.state = breakerOpen
+			b.openedAt = time.Now()
+			b.err = err
+			if _, ok := err.(*RequestError); !ok {
+				// Like ErrDead: a failed reopen is the socket's problem, not
+				// the whole RPC's.
+				b.err = &RequestError{Errno: err, Code: Internal}
+			}
+			b.trips++
+		}
+	default:
+		if trial {
+			// Let the next request try instead; openedAt is unchanged so the
+			// cooldown has still passed.
+			b.state = breakerOpen
+		}
+	}
+}
+
+func (b *breaker) stats() (open bool, trips, rejected uint64) {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+
+	return b.state != breakerClosed, b.trips, b.rejected
+}
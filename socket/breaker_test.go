@@ -0,0 +1,113 @@
+package socket
+
+import (
+	"syscall"
+	"testing"
+	"time"
+
+	"go.jonnrb.io/hostapd_grpc/fakehostapd"
+)
+
+func TestOpenBreakerFailsWithRequestError(t *testing.T) {
+	b := breaker{threshold: 1, cooldown: time.Hour}
+	b.record(false, breakerFailure, syscall.ENOENT)
+
+	_, err := b.allow()
+	if reqErr, ok := err.(*RequestError); !ok || reqErr.Errno != syscall.ENOENT {
+		t.Errorf("got %#v; want a RequestError for ENOENT", err)
+	}
+}
+
+func TestBreakerTransitions(t *testing.T) {
+	b := breaker{threshold: 2, cooldown: time.Hour}
+	for _, step := range []struct {
+		name       string
+		cooledDown bool          // the cooldown has passed before the request
+		res        breakerResult // what the request shows if let through
+		rejected   bool
+		trial      bool
+		want       breakerState
+	}{
+		{"first failure", false, breakerFailure, false, false, breakerClosed},
+		{"second failure", false, breakerFailure, false, false, breakerOpen},
+		{"open", false, breakerSuccess, true, false, breakerOpen},
+		{"trial fails", true, breakerFailure, false, true, breakerOpen},
+		{"open again", false, breakerSuccess, true, false, breakerOpen},
+		{"trial gives up", true, breakerUnknown, false, true, breakerOpen},
+		{"next request tries", false, breakerSuccess, false, true, breakerClosed},
+		{"failures start over", false, breakerFailure, false, false, breakerClosed},
+	} {
+		if step.cooledDown {
+			b.openedAt = time.Now().Add(-b.cooldown)
+		}
+
+		trial, err := b.allow()
+		if rejected := err != nil; rejected != step.rejected || trial != step.trial {
+			t.Fatalf("%s: got rejected %v, trial %v; want %v, %v",
+				step.name, rejected, trial, step.rejected, step.trial)
+		}
+		if trial {
+			if b.state != breakerHalfOpen {
+				t.Errorf("%s: state %v during trial; want half-open", step.name, b.state)
+			}
+			if _, err := b.allow(); err == nil {
+				t.Errorf("%s: let a second request through during the trial", step.name)
+			}
+		}
+		if err == nil {
+			b.record(trial, step.res, syscall.ECONNREFUSED)
+		}
+		if b.state != step.want {
+			t.Errorf("%s: state %v; want %v", step.name, b.state, step.want)
+		}
+	}
+	if _, trips, _ := b.stats(); trips != 2 {
+		t.Errorf("tripped %d times; want 2", trips)
+	}
+}
+
+func TestManagerBreakerOpensAndCloses(t *testing.T) {
+	h, clientDir := startFake(t, 1, fakehostapd.Options{})
+	m := &Manager{
+		HostapdDir:       h.Dir,
+		ClientDir:        clientDir,
+		BreakerThreshold: 2,
+		BreakerCooldown:  50 * time.Millisecond,
+	}
+	s, err := m.Get("wlan0")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer s.Close()
+
+	if err := h.RemoveInterface("wlan0"); err != nil {
+		t.Fatal(err)
+	}
+	for i := 0; i < 2; i++ {
+		if _, err := s.SendRawCmd("PING"); err == nil {
+			t.Fatal("PING to a removed socket worked")
+		}
+	}
+	if st := m.Stats(); st.BreakersOpen != 1 || st.BreakerTrips != 1 {
+		t.Fatalf("%d breakers open after %d trips; want 1 and 1", st.BreakersOpen, st.BreakerTrips)
+	}
+	if _, err := s.SendRawCmd("PING"); err == nil {
+		t.Fatal("open breaker let a request through")
+	} else if _, ok := err.(*RequestError); !ok {
+		t.Errorf("open breaker failed with %#v; want a RequestError", err)
+	}
+	if st := m.Stats(); st.BreakerRejections != 1 {
+		t.Errorf("%d rejections; want 1", st.BreakerRejections)
+	}
+
+	if _, err := h.AddInterface("wlan0", fakehostapd.Options{}); err != nil {
+		t.Fatal(err)
+	}
+	time.Sleep(m.BreakerCooldown)
+	if _, err := s.SendRawCmd("PING"); err != nil {
+		t.Fatalf("trial after cooldown: %v", err)
+	}
+	if st := m.Stats(); st.BreakersOpen != 0 {
+		t.Errorf("%d breakers open after a good trial; want 0", st.BreakersOpen)
+	}
+}
@@ -0,0 +1,77 @@
+package socket
+
+import (
+	"fmt"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"testing"
+
+	"go.jonnrb.io/hostapd_grpc/fakehostapd"
+)
+
+func TestMain(m *testing.M) {
+	fakehostapd.ServeChild()
+	os.Exit(m.Run())
+}
+
+// Serves n fake hostapd sockets named wlan0, wlan1, ... until the test is over.
+// Returns the fake and a directory for client sockets.
+func startFake(tb testing.TB, n int, opts fakehostapd.Options) (*fakehostapd.Hostapd, string) {
+	tb.Helper()
+
+	h, err := fakehostapd.New("")
+	if err != nil {
+		tb.Fatal(err)
+	}
+	tb.Cleanup(func() { h.Close() })
+	for i := 0; i < n; i++ {
+		opts.Seed = int64(i)
+		if _, err := h.AddInterface(fmt.Sprintf("wlan%d", i), opts); err != nil {
+			tb.Fatal(err)
+		}
+	}
+
+	clientDir, err := ioutil.TempDir("", "hostapd_grpc")
+	if err != nil {
+		tb.Fatal(err)
+	}
+	tb.Cleanup(func() { os.RemoveAll(clientDir) })
+	return h, clientDir
+}
+
+func openFake(tb testing.TB, h *fakehostapd.Hostapd, clientDir, name string) *wpaCtrl {
+	tb.Helper()
+
+	s, err := Open(filepath.Join(h.Dir, name), clientDir)
+	if err != nil {
+		tb.Fatal(err)
+	}
+	tb.Cleanup(func() { s.Close() })
+	return s.(*wpaCtrl)
+}
+
+// Like startFake but in another process, so that benchmarks count only the
+// client's allocations.
+func startFakeProcess(tb testing.TB, n int, opts fakehostapd.Options) (dir, clientDir string) {
+	tb.Helper()
+
+	dir, err := ioutil.TempDir("", "fakehostapd")
+	if err != nil {
+		tb.Fatal(err)
+	}
+	tb.Cleanup(func() { os.RemoveAll(dir) })
+
+	stop, err := fakehostapd.StartChild(dir, n, opts)
+	if err != nil {
+		tb.Fatal(err)
+	}
+	tb.Cleanup(stop)
+
+	clientDir, err = ioutil.TempDir("", "hostapd_grpc")
+	if err != nil {
+		tb.Fatal(err)
+	}
+	tb.Cleanup(func() { os.RemoveAll(clientDir) })
+	return dir, clientDir
+}
@@ -0,0 +1,249 @@
+package socket
+
+import (
+	"context"
+	"errors"
+	"log"
+	"math/rand"
+	"sync"
+	"time"
+)
+
+// What the prober last saw of a socket.
+type Health int
+
+const (
+	// Not probed yet, or not being probed.
+	Unknown Health = iota
+	Healthy
+	// Failed fewer than DeadAfter probes in a row; still used.
+	Degraded
+	// Failed DeadAfter probes in a row. Gets fail fast until a probe, retried
+	// with exponential backoff, reconnects.
+	Dead
+)
+
+func (h Health) String() string {
+	switch h {
+	case Healthy:
+		return "healthy"
+	case Degraded:
+		return "degraded"
+	case Dead:
+		return "dead"
+	default:
+		return "unknown"
+	}
+}
+
+// What Get fails with for a socket the prober found dead.
+var ErrDead = errors.New("socket: hostapd stopped answering; waiting to retry")
+
+type ProbeOptions struct {
+	// Time between probes of a socket that isn't dead. Defaults to 10s.
+	Interval time.Duration
+
+	// How long a probe waits for PONG. Defaults to 2s.
+	Timeout time.Duration
+
+	// Failed probes in a row before a socket is dead. Defaults to 3.
+	DeadAfter int
+
+	// Cap on the time between probes of a dead socket, which doubles from
+	// Interval with each failure. Defaults to 5m, or Interval if that is
+	// longer.
+	MaxBackoff time.Duration
+
+	// If set, called whenever a socket's health changes.
+	OnChange func(name string, h Health)
+}
+
+func (opts *ProbeOptions) setDefaults() {
+	if opts.Interval <= 0 {
+		opts.Interval = 10 * time.Second
+	}
+	if opts.Timeout <= 0 {
+		opts.Timeout = 2 * time.Second
+	}
+	if opts.DeadAfter <= 0 {
+		opts.DeadAfter = 3
+	}
+	if opts.MaxBackoff <= 0 {
+		opts.MaxBackoff = 5 * time.Minute
+	}
+	if opts.MaxBackoff < opts.Interval {
+		opts.MaxBackoff = opts.Interval
+	}
+}
+
+// PINGs every available socket on its own schedule until ctx is done, keeping
+// track of each one's Health. Requests for sockets found dead fail fast with
+// ErrDead instead of each waiting out a timeout and a reconnect; the prober
+// does the reconnecting. Only one Probe may run at a time.
+func (m *Manager) Probe(ctx context.Context, opts ProbeOptions) {
+	opts.setDefaults()
+
+	var wg sync.WaitGroup
+	probers := make(map[string]context.CancelFunc)
+	defer func() {
+		for _, cancel := range probers {
+			cancel()
+		}
+		// Nothing is known once probing stops.
+		wg.Wait()
+	}()
+
+	t := time.NewTicker(opts.Interval)
+	defer t.Stop()
+	for {
+		if names, err := m.Available(); err != nil {
+			log.Println("Error listing sockets to probe:", err)
+		} else {
+			present := make(map[string]struct{}, len(names))
+			for _, name := range names {
+				present[name] = struct{}{}
+				if _, ok := probers[name]; ok {
+					continue
+				}
+				pctx, cancel := context.WithCancel(ctx)
+				probers[name] = cancel
+				wg.Add(1)
+				go func(name string) {
+					defer wg.Done()
+					m.probeLoop(pctx, name, opts)
+				}(name)
+			}
+			for name, cancel := range probers {
+				if _, ok := present[name]; !ok {
+					cancel()
+					delete(probers, name)
+				}
+			}
+		}
+
+		select {
+		case <-t.C:
+		case <-ctx.Done():
+			return
+		}
+	}
+}
+
+func (m *Manager) probeLoop(ctx context.Context, name string, opts ProbeOptions) {
+	defer m.setHealth(name, Unknown, opts.OnChange)
+
+	now := make(chan struct{}, 1)
+	m.mu.Lock()
+	if m.probeNow == nil {
+		m.probeNow = make(map[string]chan struct{})
+	}
+	m.probeNow[name] = now
+	m.mu.Unlock()
+	defer func() {
+		m.mu.Lock()
+		if m.probeNow[name] == now {
+			delete(m.probeNow, name)
+		}
+		m.mu.Unlock()
+	}()
+
+	// Spread the first probes out so that sockets aren't all pinged at once.
+	wait := time.Duration(rand.Int63n(int64(opts.Interval)))
+	failures := 0
+	t := time.NewTimer(wait)
+	defer t.Stop()
+	for {
+		select {
+		case <-t.C:
+		case <-now:
+			if !t.Stop() {
+				<-t.C
+			}
+		case <-ctx.Done():
+			return
+		}
+
+		pctx, cancel := context.WithTimeout(ctx, opts.Timeout)
+		err := m.warm(pctx, name)
+		cancel()
+		if ctx.Err() != nil {
+			return
+		}
+
+		h := Healthy
+		wait = opts.Interval
+		if err == nil {
+			failures = 0
+		} else if failures++; failures < opts.DeadAfter {
+			h = Degraded
+		} else {
+			h = Dead
+			for i := opts.DeadAfter; i < failures && wait < opts.MaxBackoff; i++ {
+				wait *= 2
+			}
+			if wait > opts.MaxBackoff {
+				wait = opts.MaxBackoff
+			}
+		}
+		if changed := m.setHealth(name, h, opts.OnChange); changed && err != nil {
+			log.Printf("Socket %q is %v: %v", name, h, err)
+		} else if changed {
+			log.Printf("Socket %q is %v", name, h)
+		}
+		t.Reset(wait)
+	}
+}
+
+// Has name probed now rather than when its prober next gets to it, if it is
+// being probed. A dead socket that has come back would otherwise keep failing
+// fast for up to MaxBackoff.
+func (m *Manager) probeSoon(name string) {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+
+	select {
+	case m.probeNow[name] <- struct{}{}:
+	default:
+	}
+}
+
+// Returns whether h is a change.
+func (m *Manager) setHealth(name string, h Health, onChange func(string, Health)) bool {
+	m.mu.Lock()
+	prev := m.health[name]
+	if h == Unknown {
+		delete(m.health, name)
+	} else {
+		if m.health == nil {
+			m.health = make(map[string]Health)
+		}
+		m.health[name] = h
+	}
+	if h == Dead && prev != Dead {
+		// The connections are no good, and the next probe reconnects.
+		if s, ok := m.sockets[name]; ok {
+			m.drop(s)
+		}
+	}
+	m.mu.Unlock()
+
+	if h == prev {
+		return false
+	}
+	if onChange != nil {
+		onChange(name, h)
+	}
+	return true
+}
+
+// The health of every socket being probed.
+func (m *Manager) Health() map[string]Health {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+
+	health := make(map[string]Health, len(m.health))
+	for name, h := range m.health {
+		health[name] = h
+	}
+	return health
+}
@@ -0,0 +1,156 @@
+package socket
+
+import (
+	"context"
+	"sync"
+	"testing"
+	"time"
+
+	"go.jonnrb.io/hostapd_grpc/fakehostapd"
+)
+
+func TestProbeOptionsDefaults(t *testing.T) {
+	for _, c := range []struct {
+		interval, maxBackoff time.Duration
+		want                 time.Duration
+	}{
+		{0, 0, 5 * time.Minute},
+		{time.Second, time.Minute, time.Minute},
+		{time.Minute, time.Second, time.Minute},
+		{10 * time.Minute, 0, 10 * time.Minute},
+	} {
+		opts := ProbeOptions{Interval: c.interval, MaxBackoff: c.maxBackoff}
+		opts.setDefaults()
+		if opts.MaxBackoff != c.want {
+			t.Errorf("Interval %v, MaxBackoff %v: got MaxBackoff %v; want %v",
+				c.interval, c.maxBackoff, opts.MaxBackoff, c.want)
+		}
+	}
+}
+
+func TestRestartedSocketIsProbedAtOnce(t *testing.T) {
+	h, clientDir := startFake(t, 1, fakehostapd.Options{})
+	m := &Manager{HostapdDir: h.Dir, ClientDir: clientDir}
+
+	ctx, cancel := context.WithCancel(context.Background())
+	var wg sync.WaitGroup
+	defer wg.Wait()
+	defer cancel()
+	wg.Add(2)
+	go func() {
+		defer wg.Done()
+		m.Watch(ctx)
+	}()
+	go func() {
+		defer wg.Done()
+		// Long enough that only being woken up probes.
+		m.Probe(ctx, ProbeOptions{Interval: time.Hour})
+	}()
+	waitFor(t, "prober to start", func() bool {
+		m.mu.Lock()
+		defer m.mu.Unlock()
+		return m.present != nil && m.probeNow["wlan0"] != nil
+	})
+
+	m.setHealth("wlan0", Dead, nil)
+	if _, err := m.Get("wlan0"); !isErrDead(err) {
+		t.Fatalf("got %v; want ErrDead", err)
+	}
+
+	// hostapd restarts.
+	if err := h.RemoveInterface("wlan0"); err != nil {
+		t.Fatal(err)
+	}
+	if _, err := h.AddInterface("wlan0", fakehostapd.Options{}); err != nil {
+		t.Fatal(err)
+	}
+	waitFor(t, "socket to be usable again", func() bool {
+		s, err := m.Get("wlan0")
+		if err != nil {
+			return false
+		}
+		s.Close()
+		return true
+	})
+	if got := m.Health()["wlan0"]; got != Healthy {
+		t.Errorf("got %v; want healthy", got)
+	}
+}
+
+func waitFor(t *testing.T, what string, cond func() bool) {
+	t.Helper()
+
+	deadline := time.Now().Add(5 * time.Second)
+	for !cond() {
+		if time.Now().After(deadline) {
+			t.Fatal("timed out waiting for", what)
+		}
+		time.Sleep(10 * time.Millisecond)
+	}
+}
+
+func TestProberTransitions(t *testing.T) {
+	h, clientDir := startFake(t, 1, fakehostapd.Options{})
+	m := &Manager{HostapdDir: h.Dir, ClientDir: clientDir}
+
+	changes := make(chan Health, 16)
+	ctx, cancel := context.WithCancel(context.Background())
+	done := make(chan struct{})
+	go func() {
+		defer close(done)
+		m.probeLoop(ctx, "wlan0", ProbeOptions{
+			Interval:   10 * time.Millisecond,
+			Timeout:    time.Second,
+			DeadAfter:  2,
+			MaxBackoff: 40 * time.Millisecond,
+			OnChange:   func(_ string, h Health) { changes <- h },
+		})
+	}()
+
+	for _, step := range []struct {
+		name   string
+		action func() error
+		want   Health
+	}{
+		{"answering", nil, Healthy},
+		{"gone", func() error { return h.RemoveInterface("wlan0") }, Degraded},
+		{"still gone", nil, Dead},
+		{"back", func() error {
+			_, err := h.AddInterface("wlan0", fakehostapd.Options{})
+			return err
+		}, Healthy},
+	} {
+		if step.action != nil {
+			if err := step.action(); err != nil {
+				t.Fatal(err)
+			}
+		}
+		select {
+		case got := <-changes:
+			if got != step.want {
+				t.Fatalf("%s: went %v; want %v", step.name, got, step.want)
+			}
+		case <-time.After(5 * time.Second):
+			t.Fatalf("%s: never went %v", step.name, step.want)
+		}
+
+		s, err := m.Get("wlan0")
+		if err == nil {
+			s.Close()
+		}
+		if isErrDead(err) != (step.want == Dead) {
+			t.Errorf("%s: Get failed with %v", step.name, err)
+		}
+	}
+
+	cancel()
+	<-done
+	if got := <-changes; got != Unknown {
+		t.Errorf("went %v after probing stopped; want unknown", got)
+	}
+}
+
+func isErrDead(err error) bool {
+	reqErr, ok := err.(*RequestError)
+	return ok && reqErr.Errno == ErrDead
+}
@@ -1,48 +1,148 @@
 package socket
 
 import (
+	"context"
 	"errors"
+	"fmt"
 	"log"
 	"os"
 	"path"
+	"sort"
 	"sync"
 	"syscall"
+	"time"
 )
 
 type Manager struct {
 	HostapdDir string
 	ClientDir  string
 	Limit      int
+	Options    Options
+
+	// How many connections each hostapd socket may have open so that
+	// concurrent requests to it don't wait on each other. They are opened as
+	// needed. Zero means one.
+	PoolSize int
+
+	// Connections beyond the first that have been idle this long are closed.
+	// Zero keeps them open.
+	PoolIdleTimeout time.Duration
+
+	// After this many failed reconnects or dead connections in a row, requests
+	// to a socket fail right away with the last error for BreakerCooldown, after
+	// which one request is let through to see if hostapd is back. Zero never
+	// stops trying.
+	BreakerThreshold int
+	BreakerCooldown  time.Duration
+
+	// If set, connections are opened on the engine (a Reactor or a Ring)
+	// instead of each request blocking a thread in C.
+	Engine Engine
 
 	// It's best to avoid opening redundant connections to the hostapd control
 	// sockets. It works, but it's ugly.
-	mu      sync.Mutex
-	sockets map[string]*sharedSocket
-	cached  int
+	//
+	// Every socket in the map holds a cache ref and is on the LRU list, most
+	// recently used first.
+	mu             sync.Mutex
+	sockets        map[string]*sharedSocket
+	opening        map[string]*pendingOpen
+	newest, oldest *sharedSocket
+	stats          ManagerStats
+
+	// The sockets in HostapdDir while Watch runs; nil otherwise.
+	present map[string]struct{}
+
+	// Set by Probe. probeNow wakes a socket's prober early.
+	health   map[string]Health
+	probeNow map[string]chan struct{}
+}
+
+// An open in progress. err is set before done is closed.
+type pendingOpen struct {
+	done chan struct{}
+	err  error
+}
+
+// Counts of how Get calls were served, for sizing Limit, and of the
+// connections behind the cached sockets, for sizing PoolSize.
+type ManagerStats struct {
+	Hits      uint64 // served by an already open socket
+	Misses    uint64 // had to open a socket
+	Evictions uint64 // closed a socket to stay under Limit
+	Cached    int    // sockets open now
+
+	Conns       int    // connections open now
+	ConnsInUse  int    // connections with a request on them now
+	ConnsOpened uint64 // connections opened by pools, including reconnects
+	ConnsClosed uint64 // connections closed by pools for being idle
+
+	BreakersOpen      int    // sockets failing requests without trying them
+	BreakerTrips      uint64 // times a breaker opened
+	BreakerRejections uint64 // requests failed by an open breaker
+}
+
+// An alternative to the blocking cgo request path.
+type Engine interface {
+	Open(device, clientDir string, opts Options) (Socket, error)
+	OpenMonitor(device, clientDir string, opts Options) (Monitor, error)
 }
 
 type sharedSocket struct {
-	device, clientDir string
+	name        string
+	open        func() (Socket, error)
+	idleTimeout time.Duration
+
+	// The LRU list; guarded by the Manager's mu.
+	newer, older *sharedSocket
 
-	smu sync.Mutex
-	s   Socket
+	// Bounds how many connections are in use at once.
+	slots chan struct{}
+
+	breaker breaker
+
+	pmu     sync.Mutex
+	idle    []*pooledConn // least recently used first
+	inUse   int
+	opened  uint64
+	reaped  uint64
+	reaping bool
+	closed  bool
 
 	fmu    sync.Mutex
 	refs   int
 	cached bool // a single ref from a cache
 }
 
-func openShared(device, clientDir string) (*sharedSocket, error) {
-	s, err := Open(device, clientDir)
+type pooledConn struct {
+	s        Socket // nil if the last reconnect failed
+	lastUsed time.Time
+}
+
+// Opens the first connection right away so that a socket that doesn't exist
+// fails here.
+func (m *Manager) openShared(name string, open func() (Socket, error)) (*sharedSocket, error) {
+	s, err := open()
 	if err != nil {
 		return nil, err
 	}
 
+	size := m.PoolSize
+	if size < 1 {
+		size = 1
+	}
 	return &sharedSocket{
-		device:    device,
-		clientDir: clientDir,
-		s:         s,
-		refs:      1,
+		name:        name,
+		open:        open,
+		idleTimeout: m.PoolIdleTimeout,
+		slots:       make(chan struct{}, size),
+		breaker: breaker{
+			threshold: m.BreakerThreshold,
+			cooldown:  m.BreakerCooldown,
+		},
+		idle:   []*pooledConn{{s: s, lastUsed: time.Now()}},
+		opened: 1,
+		refs:   1,
 	}, nil
 }
 
@@ -62,35 +162,184 @@ func isSocketDead(err error) (dead bool) {
 	return
 }
 
-// sh.smu must be held.
-func (sh *sharedSocket) reconnect() error {
-	sh.s.Close()
-	sh.s = nil
+func (sh *sharedSocket) reconnect(c *pooledConn) error {
+	if c.s != nil {
+		c.s.Close()
+		c.s = nil
+	}
 
 	var err error
-	sh.s, err = Open(sh.device, sh.clientDir)
+	c.s, err = sh.open()
+	if err == nil {
+		sh.pmu.Lock()
+		sh.opened++
+		sh.pmu.Unlock()
+	}
 	return err
 }
 
-func (sh *sharedSocket) SendRawCmd(cmd string) (string, error) {
-	sh.smu.Lock()
-	defer sh.smu.Unlock()
+// Takes the most recently used idle connection so the others can age out, or a
+// new unopened one if none are idle. A slot must be held.
+func (sh *sharedSocket) get() *pooledConn {
+	sh.pmu.Lock()
+	defer sh.pmu.Unlock()
+
+	sh.inUse++
+	if n := len(sh.idle); n > 0 {
+		c := sh.idle[n-1]
+		sh.idle[n-1] = nil
+		sh.idle = sh.idle[:n-1]
+		return c
+	}
+	return &pooledConn{}
+}
+
+func (sh *sharedSocket) put(c *pooledConn) {
+	sh.pmu.Lock()
+	defer sh.pmu.Unlock()
 
-	s, err := sh.s.SendRawCmd(cmd)
+	sh.inUse--
+	if sh.closed {
+		if c.s != nil {
+			c.s.Close()
+		}
+		return
+	}
+
+	c.lastUsed = time.Now()
+	sh.idle = append(sh.idle, c)
+	if sh.idleTimeout > 0 && len(sh.idle) > 1 && !sh.reaping {
+		sh.reaping = true
+		time.AfterFunc(sh.idleTimeout, sh.reap)
+	}
+}
+
+// Closes connections idle for longer than idleTimeout, keeping at least one.
+func (sh *sharedSocket) reap() {
+	sh.pmu.Lock()
+	defer sh.pmu.Unlock()
+
+	sh.reaping = false
+	if sh.closed {
+		return
+	}
+
+	cutoff := time.Now().Add(-sh.idleTimeout)
+	n := 0
+	for n < len(sh.idle)-1 && sh.idle[n].lastUsed.Before(cutoff) {
+		if s := sh.idle[n].s; s != nil {
+			s.Close()
+			sh.reaped++
+		}
+		n++
+	}
+	sh.idle = append(sh.idle[:0], sh.idle[n:]...)
+
+	if len(sh.idle) > 1 {
+		sh.reaping = true
+		time.AfterFunc(sh.idle[0].lastUsed.Sub(cutoff), sh.reap)
+	}
+}
+
+func (sh *sharedSocket) do(ctx context.Context, f func(Socket) error) (err error) {
+	trial, err := sh.breaker.allow()
+	if err != nil {
+		return err
+	}
+	var (
+		res     breakerResult
+		failErr error
+	)
+	defer func() { sh.breaker.record(trial, res, failErr) }()
+
+	select {
+	case sh.slots <- struct{}{}:
+	case <-ctx.Done():
+		if ctx.Err() == context.DeadlineExceeded {
+			return &RequestError{Errno: ctx.Err(), Code: DeadlineExceeded}
+		}
+		return &RequestError{Errno: ctx.Err(), Code: Canceled}
+	}
+	defer func() { <-sh.slots }()
+
+	c := sh.get()
+	defer sh.put(c)
+
+	// New, or the last reconnect failed.
+	if c.s == nil {
+		if err := sh.reconnect(c); err != nil {
+			res, failErr = breakerFailure, err
+			return err
+		}
+	}
+
+	err = f(c.s)
+
+	// A reply to an abandoned request would be mistaken for the reply to the
+	// next one, so start over on a fresh connection.
+	if isAbandoned(err) {
+		if rErr := sh.reconnect(c); rErr != nil {
+			log.Println("Could not replace abandoned socket:", rErr)
+			res, failErr = breakerFailure, rErr
+		}
+		return err
+	}
 
 	// Try to save a borked socket once per call.
-	if isSocketDead(err) {
+	if isSocketDead(err) && ctx.Err() == nil {
 		log.Println("Recovering dead socket; err =", err)
-		err = sh.reconnect()
+		err = sh.reconnect(c)
 		if err != nil {
 			log.Println("Could not recover dead socket:", err)
-			return "", err
+			res, failErr = breakerFailure, err
+			return err
 		}
 		log.Println("Recovered dead socket")
-		s, err = sh.s.SendRawCmd(cmd)
+		err = f(c.s)
 	}
 
-	return s, err
+	if isSocketDead(err) {
+		res, failErr = breakerFailure, err
+	} else if !isAbandoned(err) {
+		res = breakerSuccess
+	}
+	return err
+}
+
+func (sh *sharedSocket) SendRawCmd(cmd string) (string, error) {
+	return sh.SendRawCmdContext(context.Background(), cmd)
+}
+
+func (sh *sharedSocket) SendRawCmdContext(ctx context.Context, cmd string) (res string, err error) {
+	err = sh.do(ctx, func(s Socket) (err error) {
+		res, err = s.SendRawCmdContext(ctx, cmd)
+		return
+	})
+	return
+}
+
+func (sh *sharedSocket) ListStations(ctx context.Context) (res string, err error) {
+	err = sh.do(ctx, func(s Socket) (err error) {
+		res, err = s.ListStations(ctx)
+		return
+	})
+	return
+}
+
+func (sh *sharedSocket) AppendRawCmd(ctx context.Context, dst []byte, cmd string) (res []byte, err error) {
+	err = sh.do(ctx, func(s Socket) (err error) {
+		res, err = s.AppendRawCmd(ctx, dst, cmd)
+		return
+	})
+	return
+}
+
+func (sh *sharedSocket) AppendStations(ctx context.Context, dst []byte) (res []byte, err error) {
+	err = sh.do(ctx, func(s Socket) (err error) {
+		res, err = s.AppendStations(ctx, dst)
+		return
+	})
+	return
 }
 
 func (sh *sharedSocket) inc() (closed bool) {
@@ -126,24 +375,12 @@ func (sh *sharedSocket) uncache() (closed bool, err error) {
 
 	sh.cached = false
 	if sh.refs == 0 {
-		sh.smu.Lock()
-		defer sh.smu.Unlock()
-
-		s := sh.s
-		sh.s = nil
-		return true, s.Close()
+		return true, sh.closeConns()
 	} else {
 		return false, nil
 	}
 }
 
-func (sh *sharedSocket) isOpen() bool {
-	sh.fmu.Lock()
-	defer sh.fmu.Unlock()
-
-	return !sh.cached && sh.refs == 0
-}
-
 func (sh *sharedSocket) Close() error {
 	sh.fmu.Lock()
 	defer sh.fmu.Unlock()
@@ -154,78 +391,300 @@ func (sh *sharedSocket) Close() error {
 
 	sh.refs--
 	if sh.refs == 0 && !sh.cached {
-		sh.smu.Lock()
-		defer sh.smu.Unlock()
-
-		s := sh.s
-		sh.s = nil
-		return s.Close()
+		return sh.closeConns()
 	} else {
 		return nil
 	}
 }
 
+// Closes the idle connections now and the ones in use when their requests
+// finish.
+func (sh *sharedSocket) closeConns() (err error) {
+	sh.pmu.Lock()
+	defer sh.pmu.Unlock()
+
+	sh.closed = true
+	for _, c := range sh.idle {
+		if c.s == nil {
+			continue
+		}
+		if cErr := c.s.Close(); err == nil {
+			err = cErr
+		}
+	}
+	sh.idle = nil
+	return
+}
+
+func (sh *sharedSocket) poolStats() (conns, inUse int, opened, reaped uint64) {
+	sh.pmu.Lock()
+	defer sh.pmu.Unlock()
+
+	for _, c := range sh.idle {
+		if c.s != nil {
+			conns++
+		}
+	}
+	return conns + sh.inUse, sh.inUse, sh.opened, sh.reaped
+}
+
+// m.mu must be held.
+func (m *Manager) pushNewest(s *sharedSocket) {
+	s.older = m.newest
+	s.newer = nil
+	if m.newest != nil {
+		m.newest.newer = s
+	} else {
+		m.oldest = s
+	}
+	m.newest = s
+}
+
 // m.mu must be held.
+func (m *Manager) unlink(s *sharedSocket) {
+	if s.newer != nil {
+		s.newer.older = s.older
+	} else {
+		m.newest = s.older
+	}
+	if s.older != nil {
+		s.older.newer = s.newer
+	} else {
+		m.oldest = s.newer
+	}
+	s.newer, s.older = nil, nil
+}
+
+// Drops the cache ref of the least recently used sockets until there is room
+// for need more. Sockets still in use stay open until their last Close.
 //
-// TODO: Use LRU heap.
+// m.mu must be held.
 func (m *Manager) evict(need int) {
-	for k, sock := range m.sockets {
-		if !sock.isOpen() {
-			delete(m.sockets, k)
-		} else if m.cached > m.Limit-need && sock.cached {
-			m.cached--
-			closed, err := sock.uncache()
-			if closed {
-				delete(m.sockets, k)
-			}
-			_ = err // TODO: log err
-		}
+	for m.oldest != nil && len(m.sockets) > m.Limit-need {
+		m.stats.Evictions++
+		m.drop(m.oldest)
+	}
+}
+
+// Removes s from the cache and drops its cache ref.
+//
+// m.mu must be held.
+func (m *Manager) drop(s *sharedSocket) {
+	m.unlink(s)
+	delete(m.sockets, s.name)
+	// Keep the counters from going backwards.
+	_, _, opened, reaped := s.poolStats()
+	m.stats.ConnsOpened += opened
+	m.stats.ConnsClosed += reaped
+	_, trips, rejected := s.breaker.stats()
+	m.stats.BreakerTrips += trips
+	m.stats.BreakerRejections += rejected
+	if _, err := s.uncache(); err != nil {
+		log.Printf("Error closing socket %q: %v", s.name, err)
 	}
 }
 
+// Opening a socket can be slow (or hang until it times out if hostapd is
+// wedged), so it happens without m.mu held. Concurrent Gets of a socket that is
+// being opened wait for that open instead of starting their own.
 func (m *Manager) Get(name string) (Socket, error) {
+	return m.get(name, true)
+}
+
+// Unless failFast is false, sockets the prober found dead aren't opened.
+func (m *Manager) get(name string, failFast bool) (Socket, error) {
+	m.mu.Lock()
+	if failFast && m.health[name] == Dead {
+		m.mu.Unlock()
+		return nil, &RequestError{Errno: ErrDead, Code: Internal}
+	}
+	for {
+		if s, ok := m.sockets[name]; ok {
+			// The cache ref keeps it open.
+			if closed := s.inc(); closed {
+				panic("socket: cached socket was closed")
+			}
+			if m.newest != s {
+				m.unlink(s)
+				m.pushNewest(s)
+			}
+			m.stats.Hits++
+			m.mu.Unlock()
+			return s, nil
+		}
+
+		o, ok := m.opening[name]
+		if !ok {
+			break
+		}
+		m.mu.Unlock()
+		<-o.done
+		if o.err != nil {
+			return nil, o.err
+		}
+		// It's cached now unless it was evicted in the meantime.
+		m.mu.Lock()
+	}
+
+	if m.opening == nil {
+		m.opening = make(map[string]*pendingOpen)
+	}
+	o := &pendingOpen{done: make(chan struct{})}
+	m.opening[name] = o
+	m.stats.Misses++
+	m.mu.Unlock()
+
+	device := path.Join(m.HostapdDir, name)
+	s, err := m.openShared(name, func() (Socket, error) {
+		if m.Engine != nil {
+			return m.Engine.Open(device, m.ClientDir, m.Options)
+		}
+		return OpenWithOptions(device, m.ClientDir, m.Options)
+	})
+
 	m.mu.Lock()
 	defer m.mu.Unlock()
 
+	delete(m.opening, name)
+	o.err = err
+	close(o.done)
+	if err != nil {
+		return nil, err
+	}
+
 	if m.sockets == nil {
 		m.sockets = make(map[string]*sharedSocket)
 	}
+	if m.Limit > 0 {
+		m.evict(1)
+	}
+	if closed := s.cache(); closed {
+		panic("socket: cannot be closed here!")
+	}
+	m.sockets[name] = s
+	m.pushNewest(s)
+	return s, nil
+}
 
-	store := func(s *sharedSocket) {
-		if m.Limit != 0 && len(m.sockets) >= m.Limit {
-			m.evict(1)
-		}
-		if !s.cached {
-			if closed := s.cache(); closed {
-				panic("socket: cannot be closed here!")
-			}
-			m.cached++
-		}
-		m.sockets[name] = s
+// Closes the cached connections. Sockets handed out by Get stay usable until
+// they are closed, and the Manager can still be used afterwards.
+func (m *Manager) Close() {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+
+	for _, s := range m.sockets {
+		m.drop(s)
 	}
+}
 
-	s, ok := m.sockets[name]
-	if ok {
-		if closed := s.inc(); !closed {
-			store(s)
-			return s, nil
+func (m *Manager) Stats() ManagerStats {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+
+	st := m.stats
+	st.Cached = len(m.sockets)
+	for _, s := range m.sockets {
+		conns, inUse, opened, reaped := s.poolStats()
+		st.Conns += conns
+		st.ConnsInUse += inUse
+		st.ConnsOpened += opened
+		st.ConnsClosed += reaped
+
+		open, trips, rejected := s.breaker.stats()
+		if open {
+			st.BreakersOpen++
 		}
+		st.BreakerTrips += trips
+		st.BreakerRejections += rejected
 	}
+	return st
+}
 
-	s, err := openShared(path.Join(m.HostapdDir, name), m.ClientDir)
+// Opens a new monitor connection to the named socket. Monitors aren't shared
+// or cached; the caller owns the returned Monitor and must Close it.
+func (m *Manager) Attach(name string) (Monitor, error) {
+	device := path.Join(m.HostapdDir, name)
+	if m.Engine != nil {
+		return m.Engine.OpenMonitor(device, m.ClientDir, m.Options)
+	}
+	return OpenMonitorWithOptions(device, m.ClientDir, m.Options)
+}
+
+// Connects to and PINGs every available socket in parallel so that the first
+// real requests don't pay for it. Returns how many answered; failures are
+// logged.
+func (m *Manager) Warm(ctx context.Context) (int, error) {
+	names, err := m.Available()
 	if err != nil {
-		return nil, err
+		return 0, err
 	}
 
-	store(s)
-	return s, nil
+	var (
+		wg sync.WaitGroup
+		mu sync.Mutex
+		ok int
+	)
+	for _, name := range names {
+		wg.Add(1)
+		go func(name string) {
+			defer wg.Done()
+			if err := m.warm(ctx, name); err != nil {
+				log.Printf("Could not warm up socket %q: %v", name, err)
+				return
+			}
+			mu.Lock()
+			ok++
+			mu.Unlock()
+		}(name)
+	}
+	wg.Wait()
+	return ok, nil
 }
 
+// Opens name if it isn't already and checks that hostapd answers on it. A
+// dead cached connection is replaced along the way.
+func (m *Manager) warm(ctx context.Context, name string) error {
+	s, err := m.get(name, false)
+	if err != nil {
+		return err
+	}
+	defer s.Close()
+
+	var buf [16]byte
+	res, err := s.AppendRawCmd(ctx, buf[:0], "PING")
+	if err != nil {
+		return err
+	}
+	if string(res) != "PONG\n" {
+		return fmt.Errorf("socket: bad response to PING: %q", res)
+	}
+	return nil
+}
+
+// Lists the sockets in HostapdDir. While Watch is running this doesn't touch
+// the filesystem.
 func (m *Manager) Available() ([]string, error) {
+	m.mu.Lock()
+	if m.present != nil {
+		socks := make([]string, 0, len(m.present))
+		for name := range m.present {
+			socks = append(socks, name)
+		}
+		m.mu.Unlock()
+		sort.Strings(socks)
+		return socks, nil
+	}
+	m.mu.Unlock()
+
+	return m.readDir()
+}
+
+func (m *Manager) readDir() ([]string, error) {
 	dir, err := os.Open(m.HostapdDir)
 	if err != nil {
 		return nil, err
 	}
+	defer dir.Close()
 
 	ents, err := dir.Readdir(0)
 	if err != nil {
@@ -238,5 +697,6 @@ func (m *Manager) Available() ([]string, error) {
 			socks = append(socks, f.Name())
 		}
 	}
+	sort.Strings(socks)
 	return socks, nil
 }
@@ -0,0 +1,132 @@
+package socket
+
+import (
+	"reflect"
+	"sync"
+	"testing"
+	"time"
+
+	"go.jonnrb.io/hostapd_grpc/fakehostapd"
+)
+
+// The cached sockets, most recently used first.
+func lru(m *Manager) (names []string) {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+
+	for s := m.newest; s != nil; s = s.older {
+		names = append(names, s.name)
+	}
+	return
+}
+
+func TestManagerEvictsLeastRecentlyUsed(t *testing.T) {
+	h, clientDir := startFake(t, 4, fakehostapd.Options{})
+	m := &Manager{HostapdDir: h.Dir, ClientDir: clientDir, Limit: 3}
+
+	for _, step := range []struct {
+		get       string
+		want      []string
+		evictions uint64
+	}{
+		{"wlan0", []string{"wlan0"}, 0},
+		{"wlan1", []string{"wlan1", "wlan0"}, 0},
+		{"wlan2", []string{"wlan2", "wlan1", "wlan0"}, 0},
+		{"wlan0", []string{"wlan0", "wlan2", "wlan1"}, 0},
+		{"wlan3", []string{"wlan3", "wlan0", "wlan2"}, 1},
+		{"wlan2", []string{"wlan2", "wlan3", "wlan0"}, 1},
+		{"wlan1", []string{"wlan1", "wlan2", "wlan3"}, 2},
+	} {
+		s, err := m.Get(step.get)
+		if err != nil {
+			t.Fatal(err)
+		}
+		s.Close()
+
+		if got := lru(m); !reflect.DeepEqual(got, step.want) {
+			t.Errorf("after getting %s: cached %v; want %v", step.get, got, step.want)
+		}
+		if got := m.Stats().Evictions; got != step.evictions {
+			t.Errorf("after getting %s: %d evictions; want %d", step.get, got, step.evictions)
+		}
+	}
+}
+
+func TestManagerKeepsEvictedSocketOpenUntilClosed(t *testing.T) {
+	h, clientDir := startFake(t, 2, fakehostapd.Options{})
+	m := &Manager{HostapdDir: h.Dir, ClientDir: clientDir, Limit: 1}
+
+	held, err := m.Get("wlan0")
+	if err != nil {
+		t.Fatal(err)
+	}
+	other, err := m.Get("wlan1")
+	if err != nil {
+		t.Fatal(err)
+	}
+	other.Close()
+	if got := lru(m); !reflect.DeepEqual(got, []string{"wlan1"}) {
+		t.Fatalf("cached %v; want [wlan1]", got)
+	}
+
+	if _, err := held.SendRawCmd("PING"); err != nil {
+		t.Errorf("evicted socket in use: %v", err)
+	}
+	if err := held.Close(); err != nil {
+		t.Error(err)
+	}
+}
+
+func TestPoolReapsIdleConnections(t *testing.T) {
+	for _, c := range []struct {
+		name        string
+		idleTimeout time.Duration
+		wantConns   int
+	}{
+		{"reaped", 50 * time.Millisecond, 1},
+		{"kept", 0, 3},
+	} {
+		t.Run(c.name, func(t *testing.T) {
+			// Slow enough that concurrent requests each need a connection.
+			h, clientDir := startFake(t, 1, fakehostapd.Options{Latency: fakehostapd.Fixed(20 * time.Millisecond)})
+			m := &Manager{
+				HostapdDir:      h.Dir,
+				ClientDir:       clientDir,
+				PoolSize:        3,
+				PoolIdleTimeout: c.idleTimeout,
+			}
+			s, err := m.Get("wlan0")
+			if err != nil {
+				t.Fatal(err)
+			}
+			defer s.Close()
+
+			var wg sync.WaitGroup
+			for i := 0; i < 3; i++ {
+				wg.Add(1)
+				go func() {
+					defer wg.Done()
+					if _, err := s.SendRawCmd("PING"); err != nil {
+						t.Error(err)
+					}
+				}()
+			}
+			wg.Wait()
+			if st := m.Stats(); st.Conns != 3 || st.ConnsOpened != 3 {
+				t.Fatalf("got %d connections, %d opened; want 3 and 3", st.Conns, st.ConnsOpened)
+			}
+
+			time.Sleep(3*c.idleTimeout + 100*time.Millisecond)
+			st := m.Stats()
+			if st.Conns != c.wantConns || st.ConnsClosed != uint64(3-c.wantConns) {
+				t.Errorf("got %d connections, %d closed; want %d and %d",
+					st.Conns, st.ConnsClosed, c.wantConns, 3-c.wantConns)
+			}
+
+			// What's left still works.
+			if _, err := s.SendRawCmd("PING"); err != nil {
+				t.Error(err)
+			}
+		})
+	}
+}
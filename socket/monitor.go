@@ -0,0 +1,129 @@
+package socket
+
+// #include <stdlib.h>
+// #include <wpa_ctrl.h>
+import "C"
+import (
+	"errors"
+	"net"
+	"os"
+	"syscall"
+	"unsafe"
+)
+
+// Monitor is a control connection registered with hostapd (ATTACH) so that it
+// receives unsolicited event messages like "<3>AP-STA-CONNECTED <addr>".
+type Monitor interface {
+	// Blocks until the next event message arrives or the monitor is closed.
+	Recv() (string, error)
+	Close() error
+}
+
+type wpaMonitor struct {
+	ctrl *C.struct_wpa_ctrl
+	buf  *C.char
+
+	// A dup of the control fd registered with the Go netpoller. It is only used
+	// to wait for readability so that a pending Recv doesn't pin an OS thread;
+	// reads still go through wpa_ctrl_recv.
+	conn *net.UnixConn
+}
+
+const monitorBufSize = 4096
+
+func OpenMonitor(device, clientDir string) (Monitor, error) {
+	return OpenMonitorWithOptions(device, clientDir, Options{})
+}
+
+func OpenMonitorWithOptions(device, clientDir string, opts Options) (Monitor, error) {
+	ctrl, err := openCtrl(device, clientDir, opts)
+	if err != nil {
+		return nil, err
+	}
+
+	if ret, err := C.wpa_ctrl_attach(ctrl); ret != 0 {
+		C.wpa_ctrl_close(ctrl)
+		return nil, &RequestError{
+			Errno: err,
+			Code:  Code(ret),
+		}
+	}
+
+	conn, err := pollConn(int(C.wpa_ctrl_get_fd(ctrl)))
+	if err != nil {
+		C.wpa_ctrl_close(ctrl)
+		return nil, err
+	}
+
+	return &wpaMonitor{
+		ctrl: ctrl,
+		buf:  (*C.char)(C.malloc(monitorBufSize)),
+		conn: conn,
+	}, nil
+}
+
+func pollConn(fd int) (*net.UnixConn, error) {
+	dup, err := syscall.Dup(fd)
+	if err != nil {
+		return nil, err
+	}
+	f := os.NewFile(uintptr(dup), "wpa_ctrl")
+	defer f.Close()
+
+	c, err := net.FileConn(f)
+	if err != nil {
+		return nil, err
+	}
+	uc, ok := c.(*net.UnixConn)
+	if !ok {
+		c.Close()
+		return nil, errors.New("socket: control fd is not a unix socket")
+	}
+	return uc, nil
+}
+
+func (m *wpaMonitor) Recv() (string, error) {
+	rc, err := m.conn.SyscallConn()
+	if err != nil {
+		return "", err
+	}
+
+	var (
+		msg  string
+		rErr error
+	)
+	err = rc.Read(func(uintptr) bool {
+		replySize := C.size_t(monitorBufSize)
+		ret, errno := C.wpa_ctrl_recv(m.ctrl, m.buf, &replySize)
+		if ret != 0 {
+			if errno == syscall.EAGAIN || errno == syscall.EWOULDBLOCK {
+				return false
+			}
+			rErr = &RequestError{Errno: errno, Code: Code(ret)}
+			return true
+		}
+		msg = C.GoStringN(m.buf, C.int(replySize))
+		return true
+	})
+	if err != nil {
+		return "", err
+	}
+	return msg, rErr
+}
+
+// Closing the monitor unblocks any pending Recv. It doesn't DETACH first since
+// that is a full request round trip that can block on a wedged hostapd; hostapd
+// drops monitors whose socket has gone away on its own.
+func (m *wpaMonitor) Close() (err error) {
+	err = m.conn.Close()
+	C.wpa_ctrl_close(m.ctrl)
+	C.free(unsafe.Pointer(m.buf))
+	m.ctrl, m.buf = nil, nil
+	return
+}
+
+// Events hostapd sends to monitors when a station associates or leaves.
+const (
+	StaConnected    = "AP-STA-CONNECTED"
+	StaDisconnected = "AP-STA-DISCONNECTED"
+)
@@ -0,0 +1,558 @@
+package socket
+
+// #include <wpa_ctrl.h>
+import "C"
+import (
+	"context"
+	"errors"
+	"runtime"
+	"sync"
+	"syscall"
+	"time"
+)
+
+// Reactor multiplexes requests and unsolicited events for many control
+// connections over one epoll instance. A single goroutine locked to its OS
+// thread does all of the I/O; callers queue requests and wait for them to
+// complete, so an outstanding request costs a parked goroutine rather than a
+// thread blocked in C.
+//
+// Connections are registered edge-triggered for their lifetime. Anything
+// readable on a connection without a request in flight is a reply to an
+// abandoned request and is thrown away, but replies carry nothing tying them
+// to a request: one that arrives after the next request is sent is taken as
+// that request's reply. As with the cgo path, a timed out request spoils the
+// connection.
+type Reactor struct {
+	epfd         int
+	wakeR, wakeW int
+
+	mu       sync.Mutex
+	conns    map[int]*reactorConn // by fd
+	pending  []*reactorOp
+	cancels  []*reactorOp
+	removals []*reactorConn
+	closed   bool
+
+	// Owned by the loop goroutine.
+	inflight map[int]*reactorOp // by fd
+	buf      []byte
+	exited   chan struct{}
+}
+
+type reactorConn struct {
+	fd int
+
+	// Unsolicited messages are delivered here if non-nil; monitors only.
+	events chan string
+
+	// Closed by the loop if events was full when a message arrived. The
+	// message is lost, so the monitor is no good after that.
+	overflowed chan struct{}
+
+	// Closed by the loop once the fd is no longer registered.
+	removed chan struct{}
+}
+
+type reactorOp struct {
+	fd       int
+	cmd      []byte
+	deadline time.Time
+	sent     bool
+
+	// The reply is appended to dst.
+	dst   []byte
+	reply []byte
+	err   error
+	done  chan struct{}
+}
+
+var (
+	errReactorClosed   = errors.New("socket: reactor closed")
+	errMonitorOverflow = errors.New("socket: monitor fell behind and lost events")
+)
+
+// How many unsolicited messages a monitor may have queued before it fails.
+const reactorEventBacklog = 256
+
+func NewReactor() (*Reactor, error) {
+	epfd, err := syscall.EpollCreate1(syscall.EPOLL_CLOEXEC)
+	if err != nil {
+		return nil, err
+	}
+
+	var wake [2]int
+	if err := syscall.Pipe2(wake[:], syscall.O_CLOEXEC|syscall.O_NONBLOCK); err != nil {
+		syscall.Close(epfd)
+		return nil, err
+	}
+	ev := syscall.EpollEvent{Events: syscall.EPOLLIN, Fd: int32(wake[0])}
+	if err := syscall.EpollCtl(epfd, syscall.EPOLL_CTL_ADD, wake[0], &ev); err != nil {
+		syscall.Close(epfd)
+		syscall.Close(wake[0])
+		syscall.Close(wake[1])
+		return nil, err
+	}
+
+	r := &Reactor{
+		epfd:     epfd,
+		wakeR:    wake[0],
+		wakeW:    wake[1],
+		conns:    make(map[int]*reactorConn),
+		inflight: make(map[int]*reactorOp),
+		buf:      make([]byte, maxReplySize),
+		exited:   make(chan struct{}),
+	}
+	go r.loop()
+	return r, nil
+}
+
+// Fails everything in flight and stops the loop. Connections opened on the
+// reactor must still be closed.
+func (r *Reactor) Close() error {
+	r.mu.Lock()
+	r.closed = true
+	r.mu.Unlock()
+
+	r.wake()
+	<-r.exited
+	syscall.Close(r.wakeR)
+	syscall.Close(r.wakeW)
+	return syscall.Close(r.epfd)
+}
+
+func (r *Reactor) wake() {
+	syscall.Write(r.wakeW, []byte{0})
+}
+
+func (r *Reactor) register(fd int, events chan string) (*reactorConn, error) {
+	c := &reactorConn{
+		fd:         fd,
+		events:     events,
+		overflowed: make(chan struct{}),
+		removed:    make(chan struct{}),
+	}
+
+	r.mu.Lock()
+	defer r.mu.Unlock()
+
+	if r.closed {
+		return nil, errReactorClosed
+	}
+	ev := syscall.EpollEvent{
+		Events: syscall.EPOLLIN | syscall.EPOLLOUT | -syscall.EPOLLET,
+		Fd:     int32(fd),
+	}
+	if err := syscall.EpollCtl(r.epfd, syscall.EPOLL_CTL_ADD, fd, &ev); err != nil {
+		return nil, err
+	}
+	r.conns[fd] = c
+	return c, nil
+}
+
+// Blocks until the loop has stopped watching c, after which its fd may be
+// closed.
+func (r *Reactor) unregister(c *reactorConn) {
+	r.mu.Lock()
+	if r.closed {
+		delete(r.conns, c.fd)
+		r.mu.Unlock()
+		// The loop is gone or on its way out and won't touch c again.
+		<-r.exited
+		return
+	}
+	r.removals = append(r.removals, c)
+	r.mu.Unlock()
+
+	r.wake()
+	<-c.removed
+}
+
+// Sends cmd on fd and waits for the reply, which is appended to dst. Only one
+// request per fd may be in flight at a time.
+func (r *Reactor) do(ctx context.Context, fd int, dst, cmd []byte) ([]byte, error) {
+	deadline, ok := ctx.Deadline()
+	if !ok {
+		deadline = time.Now().Add(defaultTimeout)
+	}
+	op := &reactorOp{
+		fd:       fd,
+		cmd:      cmd,
+		deadline: deadline,
+		dst:      dst,
+		done:     make(chan struct{}),
+	}
+
+	r.mu.Lock()
+	if r.closed {
+		r.mu.Unlock()
+		return dst, errReactorClosed
+	}
+	r.pending = append(r.pending, op)
+	r.mu.Unlock()
+	r.wake()
+
+	select {
+	case <-op.done:
+	case <-ctx.Done():
+		r.mu.Lock()
+		r.cancels = append(r.cancels, op)
+		r.mu.Unlock()
+		r.wake()
+		<-op.done
+	}
+
+	if reqErr, ok := op.err.(*RequestError); ok && reqErr.Code == Canceled {
+		return dst, requestError(ctx, C.int(Canceled), nil)
+	}
+	if op.err != nil {
+		return dst, op.err
+	}
+	return op.reply, nil
+}
+
+func (r *Reactor) loop() {
+	runtime.LockOSThread()
+	defer close(r.exited)
+
+	events := make([]syscall.EpollEvent, 64)
+	for {
+		n, err := syscall.EpollWait(r.epfd, events, r.timeoutMs())
+		if err == syscall.EINTR {
+			// n is -1. Anything that was ready still is; the wake pipe is
+			// level-triggered and the connections' edges haven't been consumed.
+			continue
+		}
+		if err != nil {
+			r.shutdown(err)
+			return
+		}
+
+		for _, ev := range events[:n] {
+			fd := int(ev.Fd)
+			if fd == r.wakeR {
+				var b [64]byte
+				for {
+					if n, _ := syscall.Read(r.wakeR, b[:]); n <= 0 {
+						break
+					}
+				}
+				continue
+			}
+
+			r.mu.Lock()
+			c := r.conns[fd]
+			r.mu.Unlock()
+			if c == nil {
+				continue
+			}
+			if ev.Events&syscall.EPOLLOUT != 0 {
+				if op := r.inflight[fd]; op != nil && !op.sent {
+					r.send(op)
+				}
+			}
+			if ev.Events&(syscall.EPOLLIN|syscall.EPOLLERR|syscall.EPOLLHUP) != 0 {
+				r.receive(c)
+			}
+		}
+
+		r.mu.Lock()
+		pending, cancels, removals := r.pending, r.cancels, r.removals
+		r.pending, r.cancels, r.removals = nil, nil, nil
+		closed := r.closed
+		r.mu.Unlock()
+
+		for _, op := range pending {
+			if r.inflight[op.fd] != nil {
+				r.complete(op, nil, &RequestError{Errno: syscall.EBUSY, Code: Internal})
+				continue
+			}
+			r.inflight[op.fd] = op
+			r.send(op)
+		}
+		for _, op := range cancels {
+			if r.inflight[op.fd] == op {
+				r.complete(op, nil, &RequestError{Code: Canceled})
+			}
+		}
+		for _, c := range removals {
+			syscall.EpollCtl(r.epfd, syscall.EPOLL_CTL_DEL, c.fd, nil)
+			r.mu.Lock()
+			delete(r.conns, c.fd)
+			r.mu.Unlock()
+			if op := r.inflight[c.fd]; op != nil {
+				r.complete(op, nil, &RequestError{Errno: syscall.EBADF, Code: Internal})
+			}
+			close(c.removed)
+		}
+
+		now := time.Now()
+		for _, op := range r.inflight {
+			if !now.Before(op.deadline) {
+				r.complete(op, nil, &RequestError{Code: DeadlineExceeded})
+			}
+		}
+
+		if closed {
+			r.shutdown(errReactorClosed)
+			return
+		}
+	}
+}
+
+// Milliseconds until the earliest deadline in flight, or -1 for none.
+func (r *Reactor) timeoutMs() int {
+	var earliest time.Time
+	for _, op := range r.inflight {
+		if earliest.IsZero() || op.deadline.Before(earliest) {
+			earliest = op.deadline
+		}
+	}
+	if earliest.IsZero() {
+		return -1
+	}
+	d := time.Until(earliest)
+	if d <= 0 {
+		return 0
+	}
+	return int((d + time.Millisecond - 1) / time.Millisecond)
+}
+
+func (r *Reactor) send(op *reactorOp) {
+	err := syscall.Sendto(op.fd, op.cmd, 0, nil)
+	switch err {
+	case nil:
+		op.sent = true
+	case syscall.EAGAIN, syscall.EINTR:
+		// Retried on the next EPOLLOUT edge.
+	default:
+		r.complete(op, nil, &RequestError{Errno: err, Code: Internal})
+	}
+}
+
+// Drains everything readable on c; required with edge triggering.
+func (r *Reactor) receive(c *reactorConn) {
+	for {
+		// With MSG_TRUNC, n is the size of the whole datagram.
+		n, _, err := syscall.Recvfrom(c.fd, r.buf, syscall.MSG_DONTWAIT|syscall.MSG_TRUNC)
+		if err == syscall.EINTR {
+			continue
+		}
+		if err == syscall.EAGAIN {
+			return
+		}
+
+		op := r.inflight[c.fd]
+		if err != nil {
+			if op != nil {
+				r.complete(op, nil, &RequestError{Errno: err, Code: Internal})
+			}
+			return
+		}
+
+		if n > len(r.buf) {
+			if op != nil && op.sent && r.buf[0] != '<' {
+				r.complete(op, nil, &RequestError{Code: ReplyTooLarge})
+			}
+			continue
+		}
+
+		msg := r.buf[:n]
+		switch {
+		case n > 0 && msg[0] == '<':
+			if c.events != nil {
+				select {
+				case <-c.overflowed:
+				case c.events <- string(msg):
+				default:
+					// Recv fails rather than the event going missing.
+					close(c.overflowed)
+				}
+			}
+		case op != nil && op.sent:
+			r.complete(op, msg, nil)
+		default:
+			// A late reply to an abandoned request.
+		}
+	}
+}
+
+func (r *Reactor) complete(op *reactorOp, reply []byte, err error) {
+	if r.inflight[op.fd] == op {
+		delete(r.inflight, op.fd)
+	}
+	if err == nil {
+		op.reply = append(op.dst, reply...)
+	}
+	op.err = err
+	close(op.done)
+}
+
+func (r *Reactor) shutdown(err error) {
+	for _, op := range r.inflight {
+		r.complete(op, nil, &RequestError{Errno: err, Code: Internal})
+	}
+
+	r.mu.Lock()
+	defer r.mu.Unlock()
+
+	r.closed = true
+	for _, op := range r.pending {
+		r.complete(op, nil, &RequestError{Errno: err, Code: Internal})
+	}
+	for _, c := range r.removals {
+		close(c.removed)
+	}
+	r.pending, r.cancels, r.removals = nil, nil, nil
+}
+
+// A control connection whose requests go through a Reactor. The wpa_ctrl is
+// only used to set up and tear down the client socket.
+type reactorCtrl struct {
+	r    *Reactor
+	ctrl *C.struct_wpa_ctrl
+	conn *reactorConn
+
+	// One request in flight at a time. The buffers are reused by each.
+	mu         sync.Mutex
+	cmd, reply []byte
+}
+
+// Opens a control connection whose requests are multiplexed on r.
+func (r *Reactor) Open(device, clientDir string, opts Options) (Socket, error) {
+	ctrl, err := openCtrl(device, clientDir, opts)
+	if err != nil {
+		return nil, err
+	}
+
+	conn, err := r.register(int(C.wpa_ctrl_get_fd(ctrl)), nil)
+	if err != nil {
+		C.wpa_ctrl_close(ctrl)
+		return nil, err
+	}
+	return &reactorCtrl{r: r, ctrl: ctrl, conn: conn}, nil
+}
+
+func (c *reactorCtrl) SendRawCmd(cmd string) (string, error) {
+	return c.SendRawCmdContext(context.Background(), cmd)
+}
+
+func (c *reactorCtrl) SendRawCmdContext(ctx context.Context, cmd string) (string, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	var err error
+	c.reply, err = c.appendRawCmd(ctx, c.reply[:0], cmd)
+	if err != nil {
+		return "", err
+	}
+	return string(c.reply), nil
+}
+
+func (c *reactorCtrl) AppendRawCmd(ctx context.Context, dst []byte, cmd string) ([]byte, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	return c.appendRawCmd(ctx, dst, cmd)
+}
+
+// c.mu must be held.
+func (c *reactorCtrl) appendRawCmd(ctx context.Context, dst []byte, cmd string) ([]byte, error) {
+	c.cmd = append(c.cmd[:0], cmd...)
+	return c.r.do(ctx, c.conn.fd, dst, c.cmd)
+}
+
+func (c *reactorCtrl) ListStations(ctx context.Context) (string, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	var err error
+	c.reply, err = c.appendStations(ctx, c.reply[:0])
+	if err != nil {
+		return "", err
+	}
+	return string(c.reply), nil
+}
+
+func (c *reactorCtrl) AppendStations(ctx context.Context, dst []byte) ([]byte, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	return c.appendStations(ctx, dst)
+}
+
+// Walks the stations one request at a time. Each step is a queued request
+// rather than a cgo call, so there is nothing to batch into C. c.mu must be
+// held.
+func (c *reactorCtrl) appendStations(ctx context.Context, dst []byte) ([]byte, error) {
+	var err error
+	dst, c.cmd, err = walkStations(dst, c.cmd, func(dst, cmd []byte) ([]byte, error) {
+		return c.r.do(ctx, c.conn.fd, dst, cmd)
+	})
+	return dst, err
+}
+
+func (c *reactorCtrl) Close() error {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	c.r.unregister(c.conn)
+	_, err := C.wpa_ctrl_close(c.ctrl)
+	c.ctrl = nil
+	return err
+}
+
+type reactorMonitor struct {
+	r      *Reactor
+	ctrl   *C.struct_wpa_ctrl
+	conn   *reactorConn
+	closed chan struct{}
+	once   sync.Once
+}
+
+// Opens a monitor whose events are read by r.
+func (r *Reactor) OpenMonitor(device, clientDir string, opts Options) (Monitor, error) {
+	ctrl, err := openCtrl(device, clientDir, opts)
+	if err != nil {
+		return nil, err
+	}
+
+	events := make(chan string, reactorEventBacklog)
+	conn, err := r.register(int(C.wpa_ctrl_get_fd(ctrl)), events)
+	if err != nil {
+		C.wpa_ctrl_close(ctrl)
+		return nil, err
+	}
+	m := &reactorMonitor{r: r, ctrl: ctrl, conn: conn, closed: make(chan struct{})}
+
+	res, err := r.do(context.Background(), conn.fd, nil, []byte("ATTACH"))
+	if err == nil && string(res) != "OK\n" {
+		err = &RequestError{Code: Internal}
+	}
+	if err != nil {
+		m.Close()
+		return nil, err
+	}
+	return m, nil
+}
+
+func (m *reactorMonitor) Recv() (string, error) {
+	select {
+	case msg := <-m.conn.events:
+		return msg, nil
+	case <-m.conn.overflowed:
+		return "", errMonitorOverflow
+	case <-m.closed:
+		return "", errors.New("socket: monitor closed")
+	}
+}
+
+func (m *reactorMonitor) Close() (err error) {
+	m.once.Do(func() {
+		close(m.closed)
+		m.r.unregister(m.conn)
+		_, err = C.wpa_ctrl_close(m.ctrl)
+		m.ctrl = nil
+	})
+	return
+}
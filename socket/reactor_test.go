@@ -0,0 +1,123 @@
+package socket
+
+import (
+	"context"
+	"path/filepath"
+	"strings"
+	"syscall"
+	"testing"
+	"time"
+
+	"go.jonnrb.io/hostapd_grpc/fakehostapd"
+)
+
+func newReactor(tb testing.TB) *Reactor {
+	tb.Helper()
+
+	r, err := NewReactor()
+	if err != nil {
+		tb.Fatal(err)
+	}
+	tb.Cleanup(func() { r.Close() })
+	return r
+}
+
+// epoll_wait fails with EINTR when a signal arrives while it is blocked,
+// whatever SA_RESTART says.
+func TestReactorSurvivesSignals(t *testing.T) {
+	h, clientDir := startFake(t, 1, fakehostapd.Options{})
+	r := newReactor(t)
+	s, err := r.Open(filepath.Join(h.Dir, "wlan0"), clientDir, Options{})
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer s.Close()
+
+	// Nothing is in flight, so the loop waits in epoll with no timeout. The
+	// signal goes to any thread, so send plenty.
+	for i := 0; i < 200; i++ {
+		time.Sleep(time.Millisecond)
+		syscall.Kill(syscall.Getpid(), syscall.SIGURG)
+	}
+
+	ctx, cancel := context.WithTimeout(context.Background(), 5*time.Second)
+	defer cancel()
+	if res, err := s.SendRawCmdContext(ctx, "PING"); err != nil || res != "PONG\n" {
+		t.Fatalf("PING = %q, %v; want PONG", res, err)
+	}
+}
+
+func TestReactorMonitorFailsWhenBehind(t *testing.T) {
+	h, clientDir := startFake(t, 1, fakehostapd.Options{})
+	r := newReactor(t)
+	mon, err := r.OpenMonitor(filepath.Join(h.Dir, "wlan0"), clientDir, Options{})
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer mon.Close()
+
+	iface := h.Interface("wlan0")
+	for i := 0; i < reactorEventBacklog+1; i++ {
+		iface.Connect("")
+	}
+	select {
+	case <-mon.(*reactorMonitor).conn.overflowed:
+	case <-time.After(5 * time.Second):
+		t.Fatal("monitor didn't overflow")
+	}
+
+	// Whatever was queued may come first, but the lost event must show up as
+	// an error.
+	for i := 0; i <= reactorEventBacklog; i++ {
+		msg, err := mon.Recv()
+		if err == errMonitorOverflow {
+			return
+		} else if err != nil {
+			t.Fatal(err)
+		} else if !strings.Contains(msg, StaConnected) {
+			t.Fatalf("unexpected event %q", msg)
+		}
+	}
+	t.Fatal("Recv never failed")
+}
+
+// Replies don't say which request they answer, so a connection with an
+// abandoned request must not be used again.
+func TestManagerReconnectsAfterAbandonedRequest(t *testing.T) {
+	h, clientDir := startFake(t, 1, fakehostapd.Options{
+		Stations: 1,
+		Latency:  fakehostapd.Fixed(200 * time.Millisecond),
+	})
+	addr := h.Interface("wlan0").Stations()[0]
+
+	for _, engine := range []string{"cgo", "reactor"} {
+		t.Run(engine, func(t *testing.T) {
+			m := &Manager{HostapdDir: h.Dir, ClientDir: clientDir}
+			if engine == "reactor" {
+				m.Engine = newReactor(t)
+			}
+			s, err := m.Get("wlan0")
+			if err != nil {
+				t.Fatal(err)
+			}
+			defer s.Close()
+
+			ctx, cancel := context.WithTimeout(context.Background(), 50*time.Millisecond)
+			_, err = s.SendRawCmdContext(ctx, "PING")
+			cancel()
+			if !isAbandoned(err) {
+				t.Fatalf("PING = %v; want it to time out", err)
+			}
+
+			ctx, cancel = context.WithTimeout(context.Background(), 5*time.Second)
+			defer cancel()
+			res, err := s.SendRawCmdContext(ctx, "STA-FIRST")
+			if err != nil {
+				t.Fatal(err)
+			}
+			if !strings.HasPrefix(res, addr+"\n") {
+				t.Fatalf("STA-FIRST = %q; want station %s", res, addr)
+			}
+		})
+	}
+}
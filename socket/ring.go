@@ -0,0 +1,730 @@
+package socket
+
+// #include <wpa_ctrl.h>
+import "C"
+import (
+	"context"
+	"errors"
+	"runtime"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"time"
+	"unsafe"
+)
+
+// Ring sends requests on control connections through io_uring. Requests
+// queued by any number of goroutines are submitted together, so a Ping of
+// every socket is a handful of io_uring_enter calls instead of a send and a
+// recv per socket.
+//
+// Only what's needed is implemented, straight on the syscalls: each request
+// is a chain of SEND and RECV, each with a LINK_TIMEOUT, and an ASYNC_CANCEL
+// when its context is done. NewRing fails if the kernel (or a seccomp policy) doesn't
+// offer all of those, and the caller should stay on another path.
+type Ring struct {
+	fd int
+
+	sqRing, cqRing, sqeMem []byte
+	sqHead, sqTail         *uint32
+	sqMask, sqEntries      uint32
+	sqArray                []uint32
+	sqes                   []iouringSQE
+	cqHead, cqTail         *uint32
+	cqMask, cqEntries      uint32
+	cqes                   []iouringCQE
+
+	// A POLL_ADD on wakeR is always armed so that new requests and cancels
+	// interrupt io_uring_enter.
+	wakeR, wakeW int
+
+	mu      sync.Mutex
+	pending []*ringOp
+	cancels []*ringOp
+	closed  bool
+
+	// Owned by the loop goroutine.
+	ops         map[uint64]*ringOp
+	queue       []*ringOp // need SQEs
+	nextID      uint64
+	sqTailLocal uint32
+	outstanding uint32 // CQEs still to come
+	wakeArmed   bool
+	exited      chan struct{}
+}
+
+// io_uring ABI from linux/io_uring.h.
+const (
+	sysIoUringSetup    = 425
+	sysIoUringEnter    = 426
+	sysIoUringRegister = 427
+
+	iouringOffSQRing = 0
+	iouringOffCQRing = 0x8000000
+	iouringOffSQEs   = 0x10000000
+
+	iouringFeatSingleMmap = 1 << 0
+	iouringEnterGetEvents = 1 << 0
+	iouringRegisterProbe  = 8
+	iouringOpSupported    = 1 << 0
+
+	iosqeIOLink = 1 << 2
+
+	iouringOpPollAdd     = 6
+	iouringOpAsyncCancel = 14
+	iouringOpLinkTimeout = 15
+	iouringOpSend        = 26
+	iouringOpRecv        = 27
+)
+
+type iouringParams struct {
+	sqEntries, cqEntries, flags, sqThreadCPU, sqThreadIdle, features, wqFd uint32
+
+	resv  [3]uint32
+	sqOff iouringSQOffsets
+	cqOff iouringCQOffsets
+}
+
+type iouringSQOffsets struct {
+	head, tail, ringMask, ringEntries, flags, dropped, array, resv1 uint32
+	userAddr                                                        uint64
+}
+
+type iouringCQOffsets struct {
+	head, tail, ringMask, ringEntries, overflow, cqes, flags, resv1 uint32
+	userAddr                                                        uint64
+}
+
+type iouringSQE struct {
+	opcode      uint8
+	flags       uint8
+	ioprio      uint16
+	fd          int32
+	off         uint64
+	addr        uint64
+	len         uint32
+	opFlags     uint32
+	userData    uint64
+	bufIndex    uint16
+	personality uint16
+	spliceFdIn  int32
+	addr3       uint64
+	pad         uint64
+}
+
+type iouringCQE struct {
+	userData uint64
+	res      int32
+	flags    uint32
+}
+
+type kernelTimespec struct {
+	sec, nsec int64
+}
+
+// What each CQE of a request is for, in the low bits of its user_data. A
+// user_data of zero is the wake poll.
+const (
+	ringSend = iota
+	ringRecv
+	ringTimeout
+	ringCancel
+)
+
+type ringOp struct {
+	id       uint64
+	fd       int
+	cmd      []byte
+	buf      []byte
+	deadline time.Time
+	ts       kernelTimespec
+
+	// Only the SEND is reissued when the reply was truncated; otherwise only
+	// the RECV is, after an unsolicited message.
+	resend bool
+
+	refs     int // CQEs still to come
+	canceled bool
+	sendErr  error
+	final    bool
+
+	// Whether an ASYNC_CANCEL is in flight, and whether it should go after the
+	// SEND instead of the RECV.
+	cancelSent bool
+	cancelSend bool
+
+	// The reply is appended to dst.
+	dst   []byte
+	reply []byte
+	err   error
+	done  chan struct{}
+}
+
+const ringEntries = 256
+
+var errRingClosed = errors.New("socket: ring closed")
+
+func NewRing() (*Ring, error) {
+	var p iouringParams
+	fd, _, errno := syscall.Syscall(sysIoUringSetup, ringEntries, uintptr(unsafe.Pointer(&p)), 0)
+	if errno != 0 {
+		return nil, errno
+	}
+	r := &Ring{
+		fd:     int(fd),
+		ops:    make(map[uint64]*ringOp),
+		nextID: 1,
+		exited: make(chan struct{}),
+	}
+	if err := r.probe(); err != nil {
+		syscall.Close(r.fd)
+		return nil, err
+	}
+	if err := r.mmap(&p); err != nil {
+		r.unmap()
+		syscall.Close(r.fd)
+		return nil, err
+	}
+
+	var wake [2]int
+	if err := syscall.Pipe2(wake[:], syscall.O_CLOEXEC|syscall.O_NONBLOCK); err != nil {
+		r.unmap()
+		syscall.Close(r.fd)
+		return nil, err
+	}
+	r.wakeR, r.wakeW = wake[0], wake[1]
+
+	go r.loop()
+	return r, nil
+}
+
+// Checks that every opcode used is supported.
+func (r *Ring) probe() error {
+	const nOps = 256
+	buf := make([]byte, 16+nOps*8)
+	_, _, errno := syscall.Syscall6(sysIoUringRegister, uintptr(r.fd), iouringRegisterProbe, uintptr(unsafe.Pointer(&buf[0])), nOps, 0, 0)
+	if errno != 0 {
+		return errno
+	}
+
+	opsLen := int(buf[1])
+	for _, op := range []int{iouringOpPollAdd, iouringOpAsyncCancel, iouringOpLinkTimeout, iouringOpSend, iouringOpRecv} {
+		flags := *(*uint16)(unsafe.Pointer(&buf[16+op*8+2]))
+		if op >= opsLen || flags&iouringOpSupported == 0 {
+			return syscall.EOPNOTSUPP
+		}
+	}
+	return nil
+}
+
+func (r *Ring) mmap(p *iouringParams) (err error) {
+	const (
+		prot  = syscall.PROT_READ | syscall.PROT_WRITE
+		flags = syscall.MAP_SHARED | syscall.MAP_POPULATE
+	)
+
+	sqSize := int(p.sqOff.array + p.sqEntries*4)
+	cqSize := int(p.cqOff.cqes + p.cqEntries*uint32(unsafe.Sizeof(iouringCQE{})))
+	if p.features&iouringFeatSingleMmap != 0 && cqSize > sqSize {
+		sqSize = cqSize
+	}
+
+	if r.sqRing, err = syscall.Mmap(r.fd, iouringOffSQRing, sqSize, prot, flags); err != nil {
+		return
+	}
+	if p.features&iouringFeatSingleMmap != 0 {
+		r.cqRing = r.sqRing
+	} else if r.cqRing, err = syscall.Mmap(r.fd, iouringOffCQRing, cqSize, prot, flags); err != nil {
+		return
+	}
+	sqeSize := int(p.sqEntries) * int(unsafe.Sizeof(iouringSQE{}))
+	if r.sqeMem, err = syscall.Mmap(r.fd, iouringOffSQEs, sqeSize, prot, flags); err != nil {
+		return
+	}
+
+	u32 := func(b []byte, off uint32) *uint32 { return (*uint32)(unsafe.Pointer(&b[off])) }
+	r.sqHead, r.sqTail = u32(r.sqRing, p.sqOff.head), u32(r.sqRing, p.sqOff.tail)
+	r.sqMask, r.sqEntries = *u32(r.sqRing, p.sqOff.ringMask), p.sqEntries
+	r.sqArray = (*[1 << 16]uint32)(unsafe.Pointer(&r.sqRing[p.sqOff.array]))[:p.sqEntries:p.sqEntries]
+	r.sqes = (*[1 << 16]iouringSQE)(unsafe.Pointer(&r.sqeMem[0]))[:p.sqEntries:p.sqEntries]
+	r.cqHead, r.cqTail = u32(r.cqRing, p.cqOff.head), u32(r.cqRing, p.cqOff.tail)
+	r.cqMask, r.cqEntries = *u32(r.cqRing, p.cqOff.ringMask), p.cqEntries
+	r.cqes = (*[1 << 16]iouringCQE)(unsafe.Pointer(&r.cqRing[p.cqOff.cqes]))[:p.cqEntries:p.cqEntries]
+	r.sqTailLocal = *r.sqTail
+	return nil
+}
+
+func (r *Ring) unmap() {
+	if r.sqeMem != nil {
+		syscall.Munmap(r.sqeMem)
+	}
+	if r.cqRing != nil && &r.cqRing[0] != &r.sqRing[0] {
+		syscall.Munmap(r.cqRing)
+	}
+	if r.sqRing != nil {
+		syscall.Munmap(r.sqRing)
+	}
+	r.sqRing, r.cqRing, r.sqeMem = nil, nil, nil
+}
+
+// Fails everything queued, cancels what's in the kernel and waits for it to
+// finish. Connections opened on the ring must still be closed.
+func (r *Ring) Close() error {
+	r.mu.Lock()
+	r.closed = true
+	r.mu.Unlock()
+
+	r.wake()
+	<-r.exited
+	r.unmap()
+	syscall.Close(r.wakeR)
+	syscall.Close(r.wakeW)
+	return syscall.Close(r.fd)
+}
+
+func (r *Ring) wake() {
+	syscall.Write(r.wakeW, []byte{0})
+}
+
+// Sends cmd on fd and waits for the reply, which is appended to dst. *buf is
+// where the kernel receives into; it is allocated or grown as needed. Only one
+// request per fd may be in flight at a time.
+func (r *Ring) do(ctx context.Context, fd int, dst, cmd []byte, buf *[]byte) ([]byte, error) {
+	deadline, ok := ctx.Deadline()
+	if !ok {
+		deadline = time.Now().Add(defaultTimeout)
+	}
+	if *buf == nil {
+		*buf = make([]byte, initialReplySize)
+	}
+	op := &ringOp{
+		fd:       fd,
+		cmd:      cmd,
+		buf:      *buf,
+		deadline: deadline,
+		resend:   true,
+		dst:      dst,
+		done:     make(chan struct{}),
+	}
+
+	r.mu.Lock()
+	if r.closed {
+		r.mu.Unlock()
+		return dst, errRingClosed
+	}
+	r.pending = append(r.pending, op)
+	r.mu.Unlock()
+	r.wake()
+
+	select {
+	case <-op.done:
+	case <-ctx.Done():
+		r.mu.Lock()
+		r.cancels = append(r.cancels, op)
+		r.mu.Unlock()
+		r.wake()
+		<-op.done
+	}
+
+	*buf = op.buf
+	if reqErr, ok := op.err.(*RequestError); ok && reqErr.Code == Canceled {
+		return dst, requestError(ctx, C.int(Canceled), nil)
+	}
+	if op.err != nil {
+		return dst, op.err
+	}
+	return op.reply, nil
+}
+
+func (r *Ring) loop() {
+	runtime.LockOSThread()
+	defer close(r.exited)
+
+	for {
+		r.mu.Lock()
+		pending, cancels, closed := r.pending, r.cancels, r.closed
+		r.pending, r.cancels = nil, nil
+		r.mu.Unlock()
+
+		for _, op := range pending {
+			op.id = r.nextID
+			r.nextID++
+			r.ops[op.id] = op
+			if closed {
+				op.canceled = true
+			}
+		}
+		r.queue = append(r.queue, pending...)
+
+		if closed {
+			if len(r.ops) == 0 {
+				return
+			}
+			for _, op := range r.ops {
+				op.canceled = true
+				r.cancel(op)
+			}
+		}
+
+		for _, op := range cancels {
+			if r.ops[op.id] != op || op.final {
+				continue
+			}
+			op.canceled = true
+			r.cancel(op)
+		}
+		r.submitQueued()
+
+		if !r.wakeArmed && !closed && r.space(1) {
+			sqe := r.sqe()
+			sqe.opcode = iouringOpPollAdd
+			sqe.fd = int32(r.wakeR)
+			sqe.opFlags = uint32(syscall.EPOLLIN)
+			r.wakeArmed = true
+			r.outstanding++
+		}
+
+		if err := r.enter(); err != nil {
+			r.fail(err)
+			return
+		}
+		r.reap()
+	}
+}
+
+// Asks the kernel to give up on op. Ops that are only queued are failed when
+// their turn comes.
+func (r *Ring) cancel(op *ringOp) {
+	if op.refs == 0 || op.final || op.cancelSent || !r.space(1) {
+		return
+	}
+	target := op.id<<2 | ringRecv
+	if op.cancelSend {
+		target = op.id<<2 | ringSend
+	}
+	sqe := r.sqe()
+	sqe.opcode = iouringOpAsyncCancel
+	sqe.fd = -1
+	sqe.addr = target
+	sqe.userData = op.id<<2 | ringCancel
+	op.refs++
+	op.cancelSent = true
+	r.outstanding++
+}
+
+// Whether n more SQEs fit, counting their CQEs against the CQ ring so that it
+// can never overflow.
+func (r *Ring) space(n uint32) bool {
+	used := r.sqTailLocal - atomic.LoadUint32(r.sqHead)
+	return used+n <= r.sqEntries && r.outstanding+n <= r.cqEntries
+}
+
+func (r *Ring) sqe() *iouringSQE {
+	idx := r.sqTailLocal & r.sqMask
+	sqe := &r.sqes[idx]
+	*sqe = iouringSQE{}
+	r.sqArray[idx] = idx
+	r.sqTailLocal++
+	return sqe
+}
+
+// Issues SQEs for queued requests, as many as fit.
+func (r *Ring) submitQueued() {
+	now := time.Now()
+	i := 0
+	for ; i < len(r.queue); i++ {
+		op := r.queue[i]
+		if op.canceled {
+			op.err = &RequestError{Code: Canceled}
+			r.finish(op)
+			continue
+		}
+		remaining := op.deadline.Sub(now)
+		if remaining <= 0 {
+			op.err = &RequestError{Code: DeadlineExceeded}
+			r.finish(op)
+			continue
+		}
+
+		n := uint32(2)
+		if op.resend {
+			n = 4
+		}
+		if !r.space(n) {
+			break
+		}
+
+		// Each timeout starts when the request before it does, so a SEND that
+		// blocks on a full peer and the RECV after it may take up to twice the
+		// time remaining. The context being done cancels them sooner.
+		op.ts = kernelTimespec{
+			sec:  int64(remaining / time.Second),
+			nsec: int64(remaining % time.Second),
+		}
+		if op.resend {
+			sqe := r.sqe()
+			sqe.opcode = iouringOpSend
+			sqe.flags = iosqeIOLink
+			sqe.fd = int32(op.fd)
+			sqe.addr = uint64(uintptr(unsafe.Pointer(&op.cmd[0])))
+			sqe.len = uint32(len(op.cmd))
+			sqe.userData = op.id<<2 | ringSend
+
+			// Links on to the RECV once the SEND is done.
+			sqe = r.sqe()
+			sqe.opcode = iouringOpLinkTimeout
+			sqe.flags = iosqeIOLink
+			sqe.fd = -1
+			sqe.addr = uint64(uintptr(unsafe.Pointer(&op.ts)))
+			sqe.len = 1
+			sqe.userData = op.id<<2 | ringTimeout
+		}
+		sqe := r.sqe()
+		sqe.opcode = iouringOpRecv
+		sqe.flags = iosqeIOLink
+		sqe.fd = int32(op.fd)
+		sqe.addr = uint64(uintptr(unsafe.Pointer(&op.buf[0])))
+		sqe.len = uint32(len(op.buf))
+		// Reports the real length of a datagram that didn't fit.
+		sqe.opFlags = syscall.MSG_TRUNC
+		sqe.userData = op.id<<2 | ringRecv
+
+		sqe = r.sqe()
+		sqe.opcode = iouringOpLinkTimeout
+		sqe.fd = -1
+		sqe.addr = uint64(uintptr(unsafe.Pointer(&op.ts)))
+		sqe.len = 1
+		sqe.userData = op.id<<2 | ringTimeout
+
+		op.refs += int(n)
+		r.outstanding += n
+		op.resend = false
+	}
+	r.queue = append(r.queue[:0], r.queue[i:]...)
+}
+
+func (r *Ring) enter() error {
+	atomic.StoreUint32(r.sqTail, r.sqTailLocal)
+	for {
+		toSubmit := r.sqTailLocal - atomic.LoadUint32(r.sqHead)
+		_, _, errno := syscall.Syscall6(sysIoUringEnter, uintptr(r.fd), uintptr(toSubmit), 1, iouringEnterGetEvents, 0, 0)
+		switch errno {
+		case 0:
+			return nil
+		case syscall.EINTR:
+			if r.ready() {
+				return nil
+			}
+		case syscall.EAGAIN, syscall.EBUSY:
+			// Out of kernel resources for now; whatever has completed makes room.
+			if r.ready() {
+				return nil
+			}
+			time.Sleep(time.Millisecond)
+		default:
+			return errno
+		}
+	}
+}
+
+func (r *Ring) ready() bool {
+	return atomic.LoadUint32(r.cqTail) != *r.cqHead
+}
+
+func (r *Ring) reap() {
+	head := *r.cqHead
+	tail := atomic.LoadUint32(r.cqTail)
+	for ; head != tail; head++ {
+		cqe := r.cqes[head&r.cqMask]
+		r.outstanding--
+		if cqe.userData == 0 {
+			r.wakeArmed = false
+			var b [64]byte
+			for {
+				if n, _ := syscall.Read(r.wakeR, b[:]); n <= 0 {
+					break
+				}
+			}
+			continue
+		}
+
+		op := r.ops[cqe.userData>>2]
+		if op == nil {
+			continue
+		}
+		op.refs--
+		r.complete(op, cqe.userData&3, cqe.res)
+		if op.refs == 0 && op.final {
+			r.finish(op)
+		}
+	}
+	atomic.StoreUint32(r.cqHead, head)
+}
+
+func (r *Ring) complete(op *ringOp, kind uint64, res int32) {
+	switch kind {
+	case ringSend:
+		// A canceled SEND timed out or was canceled, which the RECV reports.
+		if res < 0 && res != -int32(syscall.ECANCELED) {
+			op.sendErr = syscall.Errno(-res)
+		}
+	case ringCancel:
+		op.cancelSent = false
+		if res == -int32(syscall.ENOENT) && !op.final {
+			// The RECV doesn't start until the SEND is done, so one of them is
+			// always there to be canceled.
+			op.cancelSend = !op.cancelSend
+			r.mu.Lock()
+			r.cancels = append(r.cancels, op)
+			r.mu.Unlock()
+		}
+	case ringRecv:
+		switch {
+		case res == -int32(syscall.ECANCELED):
+			if op.sendErr != nil {
+				op.err = &RequestError{Errno: op.sendErr, Code: Internal}
+			} else if op.canceled {
+				op.err = &RequestError{Code: Canceled}
+			} else {
+				op.err = &RequestError{Code: DeadlineExceeded}
+			}
+		case res < 0:
+			op.err = &RequestError{Errno: syscall.Errno(-res), Code: Internal}
+		case int(res) > len(op.buf):
+			if len(op.buf) >= maxReplySize {
+				op.err = &RequestError{Code: ReplyTooLarge}
+				break
+			}
+			// Every command sent is a query so asking again is safe.
+			op.buf = make([]byte, maxReplySize)
+			op.resend = true
+			r.queue = append(r.queue, op)
+			return
+		case res > 0 && op.buf[0] == '<':
+			// An unsolicited message; the reply is still to come.
+			r.queue = append(r.queue, op)
+			return
+		default:
+			op.reply = append(op.dst, op.buf[:res]...)
+		}
+		op.final = true
+	}
+}
+
+func (r *Ring) finish(op *ringOp) {
+	delete(r.ops, op.id)
+	op.final = true
+	close(op.done)
+}
+
+// The ring is unusable; fail everything. Requests the kernel may still hold
+// stay in r.ops so that their buffers aren't collected while it does.
+func (r *Ring) fail(err error) {
+	r.mu.Lock()
+	r.closed = true
+	pending := r.pending
+	r.pending = nil
+	r.mu.Unlock()
+
+	for _, op := range pending {
+		op.err = &RequestError{Errno: err, Code: Internal}
+		close(op.done)
+	}
+	for _, op := range r.ops {
+		op.err = &RequestError{Errno: err, Code: Internal}
+		close(op.done)
+	}
+	r.queue = nil
+}
+
+// A control connection whose requests go through a Ring.
+type ringCtrl struct {
+	r    *Ring
+	ctrl *C.struct_wpa_ctrl
+	fd   int
+
+	// One request in flight at a time. The buffers are reused by each.
+	mu              sync.Mutex
+	cmd, buf, reply []byte
+}
+
+// Opens a control connection whose requests are submitted on r.
+func (r *Ring) Open(device, clientDir string, opts Options) (Socket, error) {
+	ctrl, err := openCtrl(device, clientDir, opts)
+	if err != nil {
+		return nil, err
+	}
+	return &ringCtrl{r: r, ctrl: ctrl, fd: int(C.wpa_ctrl_get_fd(ctrl))}, nil
+}
+
+// Monitors spend their time waiting rather than sending, so they stay on the
+// netpoller.
+func (r *Ring) OpenMonitor(device, clientDir string, opts Options) (Monitor, error) {
+	return OpenMonitorWithOptions(device, clientDir, opts)
+}
+
+func (c *ringCtrl) SendRawCmd(cmd string) (string, error) {
+	return c.SendRawCmdContext(context.Background(), cmd)
+}
+
+func (c *ringCtrl) SendRawCmdContext(ctx context.Context, cmd string) (string, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	var err error
+	c.reply, err = c.appendRawCmd(ctx, c.reply[:0], cmd)
+	if err != nil {
+		return "", err
+	}
+	return string(c.reply), nil
+}
+
+func (c *ringCtrl) AppendRawCmd(ctx context.Context, dst []byte, cmd string) ([]byte, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	return c.appendRawCmd(ctx, dst, cmd)
+}
+
+// c.mu must be held.
+func (c *ringCtrl) appendRawCmd(ctx context.Context, dst []byte, cmd string) ([]byte, error) {
+	c.cmd = append(c.cmd[:0], cmd...)
+	return c.r.do(ctx, c.fd, dst, c.cmd, &c.buf)
+}
+
+func (c *ringCtrl) ListStations(ctx context.Context) (string, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	var err error
+	c.reply, err = c.appendStations(ctx, c.reply[:0])
+	if err != nil {
+		return "", err
+	}
+	return string(c.reply), nil
+}
+
+func (c *ringCtrl) AppendStations(ctx context.Context, dst []byte) ([]byte, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	return c.appendStations(ctx, dst)
+}
+
+// c.mu must be held.
+func (c *ringCtrl) appendStations(ctx context.Context, dst []byte) ([]byte, error) {
+	var err error
+	dst, c.cmd, err = walkStations(dst, c.cmd, func(dst, cmd []byte) ([]byte, error) {
+		return c.r.do(ctx, c.fd, dst, cmd, &c.buf)
+	})
+	return dst, err
+}
+
+func (c *ringCtrl) Close() error {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	_, err := C.wpa_ctrl_close(c.ctrl)
+	c.ctrl = nil
+	return err
+}
@@ -0,0 +1,139 @@
+package socket
+
+import (
+	"context"
+	"fmt"
+	"path/filepath"
+	"sync"
+	"testing"
+	"time"
+
+	"go.jonnrb.io/hostapd_grpc/fakehostapd"
+)
+
+func newRing(tb testing.TB) *Ring {
+	tb.Helper()
+
+	r, err := NewRing()
+	if err != nil {
+		tb.Skip("io_uring is unavailable:", err)
+	}
+	tb.Cleanup(func() { r.Close() })
+	return r
+}
+
+// Has a deadline but is never done, so only the ring's own timeouts can end a
+// request.
+type deadlineOnly struct {
+	context.Context
+	deadline time.Time
+}
+
+func (ctx deadlineOnly) Deadline() (time.Time, bool) { return ctx.deadline, true }
+
+func TestRingSendTimesOut(t *testing.T) {
+	// hostapd takes a request off the socket and then sits on it, so the
+	// requests after it fill up the socket and then block in SEND.
+	h, clientDir := startFake(t, 1, fakehostapd.Options{Latency: fakehostapd.Fixed(time.Minute)})
+	r := newRing(t)
+
+	const conns = 32
+	var wg sync.WaitGroup
+	socks := make([]Socket, conns)
+	errs := make([]error, conns)
+	for i := range socks {
+		s, err := r.Open(filepath.Join(h.Dir, "wlan0"), clientDir, Options{})
+		if err != nil {
+			t.Fatal(err)
+		}
+		socks[i] = s
+
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			ctx := deadlineOnly{context.Background(), time.Now().Add(100 * time.Millisecond)}
+			_, errs[i] = s.AppendRawCmd(ctx, nil, "PING")
+		}(i)
+	}
+
+	done := make(chan struct{})
+	go func() {
+		wg.Wait()
+		close(done)
+	}()
+	select {
+	case <-done:
+	case <-time.After(5 * time.Second):
+		// Closing the ring cancels them.
+		t.Fatal("requests outlived their deadline")
+	}
+	for _, s := range socks {
+		s.Close()
+	}
+	for i, err := range errs {
+		if reqErr, ok := err.(*RequestError); !ok || reqErr.Code != DeadlineExceeded {
+			t.Errorf("request %d: got %v; want a deadline error", i, err)
+		}
+	}
+}
+
+// Pings every socket at once, as a Ping RPC naming no sockets does, on each
+// engine.
+func BenchmarkPingFleet(b *testing.B) {
+	engines := []struct {
+		name string
+		new  func(testing.TB) Engine // nil for the cgo path
+	}{
+		{"cgo", nil},
+		{"reactor", func(tb testing.TB) Engine { return newReactor(tb) }},
+		{"ring", func(tb testing.TB) Engine { return newRing(tb) }},
+	}
+	for _, n := range []int{8, 64} {
+		h, clientDir := startFake(b, n, fakehostapd.Options{})
+		for _, e := range engines {
+			b.Run(fmt.Sprintf("%s/sockets=%d", e.name, n), func(b *testing.B) {
+				var engine Engine
+				if e.new != nil {
+					engine = e.new(b)
+				}
+				socks := make([]Socket, n)
+				for i := range socks {
+					device := filepath.Join(h.Dir, fmt.Sprintf("wlan%d", i))
+					var err error
+					if engine != nil {
+						socks[i], err = engine.Open(device, clientDir, Options{})
+					} else {
+						socks[i], err = Open(device, clientDir)
+					}
+					if err != nil {
+						b.Fatal(err)
+					}
+					defer socks[i].Close()
+				}
+				benchmarkPingFleet(b, socks)
+			})
+		}
+	}
+}
+
+func benchmarkPingFleet(b *testing.B, socks []Socket) {
+	bufs := make([][]byte, len(socks))
+	ctx := context.Background()
+	b.ResetTimer()
+	start := time.Now()
+	for i := 0; i < b.N; i++ {
+		var wg sync.WaitGroup
+		for j, s := range socks {
+			wg.Add(1)
+			go func(j int, s Socket) {
+				defer wg.Done()
+				var err error
+				if bufs[j], err = s.AppendRawCmd(ctx, bufs[j][:0], "PING"); err != nil {
+					b.Error(err)
+				}
+			}(j, s)
+		}
+		wg.Wait()
+	}
+	b.ReportMetric(float64(b.N*len(socks))/time.Since(start).Seconds(), "pings/s")
+}
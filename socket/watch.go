@@ -0,0 +1,149 @@
+package socket
+
+import (
+	"bytes"
+	"context"
+	"errors"
+	"log"
+	"os"
+	"path"
+	"syscall"
+	"unsafe"
+)
+
+// Keeps the list of sockets in HostapdDir up to date from inotify events so
+// that Available doesn't read the directory each time. Sockets that appear are
+// warmed up (see Warm) right away and cached connections to ones that
+// disappear are closed. The directory is only read when the watch starts and when the kernel
+// drops events.
+//
+// Runs until ctx is done or the watch fails, after which Available reads the
+// directory again. Only one Watch may run at a time.
+func (m *Manager) Watch(ctx context.Context) error {
+	fd, err := syscall.InotifyInit1(syscall.IN_CLOEXEC | syscall.IN_NONBLOCK)
+	if err != nil {
+		return err
+	}
+	// Non-blocking, so reads park on the runtime's poller.
+	f := os.NewFile(uintptr(fd), "inotify")
+	defer f.Close()
+
+	const mask = syscall.IN_CREATE | syscall.IN_DELETE | syscall.IN_MOVED_FROM |
+		syscall.IN_MOVED_TO | syscall.IN_DELETE_SELF | syscall.IN_MOVE_SELF |
+		syscall.IN_ONLYDIR
+	if _, err := syscall.InotifyAddWatch(fd, m.HostapdDir, mask); err != nil {
+		return err
+	}
+
+	// Scanning after the watch is added means nothing is missed in between.
+	if err := m.rescan(); err != nil {
+		return err
+	}
+	defer func() {
+		m.mu.Lock()
+		m.present = nil
+		m.mu.Unlock()
+	}()
+
+	stop := make(chan struct{})
+	defer close(stop)
+	go func() {
+		select {
+		case <-ctx.Done():
+			f.Close()
+		case <-stop:
+		}
+	}()
+
+	buf := make([]byte, 4096)
+	for {
+		n, err := f.Read(buf)
+		if err != nil {
+			if ctx.Err() != nil {
+				return nil
+			}
+			return err
+		}
+
+		for off := 0; off+syscall.SizeofInotifyEvent <= n; {
+			ev := (*syscall.InotifyEvent)(unsafe.Pointer(&buf[off]))
+			off += syscall.SizeofInotifyEvent
+			name := buf[off : off+int(ev.Len)]
+			off += int(ev.Len)
+			if i := bytes.IndexByte(name, 0); i != -1 {
+				name = name[:i]
+			}
+
+			switch {
+			case ev.Mask&syscall.IN_Q_OVERFLOW != 0:
+				log.Println("Missed changes to the hostapd dir; reading it again")
+				if err := m.rescan(); err != nil {
+					return err
+				}
+			case ev.Mask&(syscall.IN_DELETE_SELF|syscall.IN_MOVE_SELF|syscall.IN_IGNORED) != 0:
+				return errors.New("socket: hostapd dir went away")
+			case ev.Mask&(syscall.IN_CREATE|syscall.IN_MOVED_TO) != 0:
+				m.appeared(string(name))
+			case ev.Mask&(syscall.IN_DELETE|syscall.IN_MOVED_FROM) != 0:
+				m.disappeared(string(name))
+			}
+		}
+	}
+}
+
+func (m *Manager) rescan() error {
+	socks, err := m.readDir()
+	if err != nil {
+		return err
+	}
+
+	present := make(map[string]struct{}, len(socks))
+	for _, name := range socks {
+		present[name] = struct{}{}
+	}
+
+	m.mu.Lock()
+	defer m.mu.Unlock()
+
+	m.present = present
+	for name, s := range m.sockets {
+		if _, ok := present[name]; !ok {
+			m.drop(s)
+		}
+	}
+	return nil
+}
+
+func (m *Manager) appeared(name string) {
+	fi, err := os.Lstat(path.Join(m.HostapdDir, name))
+	if err != nil || fi.Mode()&os.ModeSocket == 0 {
+		return
+	}
+
+	m.mu.Lock()
+	m.present[name] = struct{}{}
+	m.mu.Unlock()
+
+	go func() {
+		ctx, cancel := context.WithTimeout(context.Background(), defaultTimeout)
+		defer cancel()
+		if err := m.warm(ctx, name); err != nil {
+			log.Printf("Could not warm up new socket %q: %v", name, err)
+			return
+		}
+		// hostapd may have restarted after being found dead.
+		m.probeSoon(name)
+	}()
+}
+
+func (m *Manager) disappeared(name string) {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+
+	delete(m.present, name)
+	// Connections to a socket that's gone are dead, and a hostapd that comes
+	// back makes a new socket under the same name.
+	if s, ok := m.sockets[name]; ok {
+		m.drop(s)
+	}
+}
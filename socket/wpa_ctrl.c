@@ -37,6 +37,10 @@
 #define CTRL_IFACE_SOCKET
 #endif /* CONFIG_CTRL_IFACE_UNIX || CONFIG_CTRL_IFACE_UDP */
 
+#ifdef CTRL_IFACE_SOCKET
+#include <poll.h>
+#endif /* CTRL_IFACE_SOCKET */
+
 /**
  * struct wpa_ctrl - Internal structure for control interface library
  *
@@ -84,8 +88,14 @@ struct wpa_ctrl *wpa_ctrl_open(const char *ctrl_path) {
 }
 
 struct wpa_ctrl *wpa_ctrl_open2(const char *ctrl_path, const char *cli_path) {
+  return wpa_ctrl_open3(ctrl_path, cli_path, NULL);
+}
+
+struct wpa_ctrl *wpa_ctrl_open3(const char *ctrl_path, const char *cli_path,
+                                const struct wpa_ctrl_opts *opts) {
   struct wpa_ctrl *ctrl;
   static int counter = 0;
+  int id;
   int ret;
   size_t res;
   int tries = 0;
@@ -102,18 +112,55 @@ struct wpa_ctrl *wpa_ctrl_open2(const char *ctrl_path, const char *cli_path) {
     return NULL;
   }
 
+  /* Buffer sizes are a hint; failing to set them is not fatal. */
+  if (opts && opts->sndbuf > 0 &&
+      setsockopt(ctrl->s, SOL_SOCKET, SO_SNDBUF, &opts->sndbuf,
+                 sizeof(opts->sndbuf)) < 0)
+    perror("setsockopt(SO_SNDBUF)");
+  if (opts && opts->rcvbuf > 0 &&
+      setsockopt(ctrl->s, SOL_SOCKET, SO_RCVBUF, &opts->rcvbuf,
+                 sizeof(opts->rcvbuf)) < 0)
+    perror("setsockopt(SO_RCVBUF)");
+
   ctrl->local.sun_family = AF_UNIX;
-  counter++;
+  /*
+   * Connections are opened from many threads at once. Each needs its own id
+   * or one could bind over (and then unlink) another's live socket file.
+   */
+  id = __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED);
 try_again:
+  if (opts && opts->abstract) {
+    /*
+     * Abstract names go away with the socket, so there is nothing to unlink
+     * and nothing left behind by a crash.
+     */
+    ctrl->local.sun_path[0] = '\0';
+    ret = os_snprintf(ctrl->local.sun_path + 1,
+                      sizeof(ctrl->local.sun_path) - 1,
+                      "%s/" CONFIG_CTRL_IFACE_CLIENT_PREFIX "%d-%d",
+                      cli_path ? cli_path : "", (int)getpid(), id);
+    if (os_snprintf_error(sizeof(ctrl->local.sun_path) - 1, ret)) {
+      close(ctrl->s);
+      os_free(ctrl);
+      return NULL;
+    }
+    if (bind(ctrl->s, (struct sockaddr *)&ctrl->local,
+             offsetof(struct sockaddr_un, sun_path) + 1 + ret) < 0) {
+      close(ctrl->s);
+      os_free(ctrl);
+      return NULL;
+    }
+    goto bound;
+  }
   if (cli_path && cli_path[0] == '/') {
     ret = os_snprintf(ctrl->local.sun_path, sizeof(ctrl->local.sun_path),
                       "%s/" CONFIG_CTRL_IFACE_CLIENT_PREFIX "%d-%d", cli_path,
-                      (int)getpid(), counter);
+                      (int)getpid(), id);
   } else {
     ret = os_snprintf(ctrl->local.sun_path, sizeof(ctrl->local.sun_path),
                       CONFIG_CTRL_IFACE_CLIENT_DIR
                       "/" CONFIG_CTRL_IFACE_CLIENT_PREFIX "%d-%d",
-                      (int)getpid(), counter);
+                      (int)getpid(), id);
   }
   if (os_snprintf_error(sizeof(ctrl->local.sun_path), ret)) {
     close(ctrl->s);
@@ -136,6 +183,7 @@ try_again:
     os_free(ctrl);
     return NULL;
   }
+bound:
 
 #ifdef ANDROID
   chmod(ctrl->local.sun_path, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
@@ -192,7 +240,7 @@ try_again:
   if (connect(ctrl->s, (struct sockaddr *)&ctrl->dest, sizeof(ctrl->dest)) <
       0) {
     close(ctrl->s);
-    unlink(ctrl->local.sun_path);
+    if (ctrl->local.sun_path[0] != '\0') unlink(ctrl->local.sun_path);
     os_free(ctrl);
     return NULL;
   }
@@ -215,7 +263,7 @@ try_again:
 
 void wpa_ctrl_close(struct wpa_ctrl *ctrl) {
   if (ctrl == NULL) return;
-  unlink(ctrl->local.sun_path);
+  if (ctrl->local.sun_path[0] != '\0') unlink(ctrl->local.sun_path);
   if (ctrl->s >= 0) close(ctrl->s);
   os_free(ctrl);
 }
@@ -428,13 +476,34 @@ void wpa_ctrl_close(struct wpa_ctrl *ctrl) {
 #endif /* CONFIG_CTRL_IFACE_UDP */
 
 #ifdef CTRL_IFACE_SOCKET
-int wpa_ctrl_request(struct wpa_ctrl *ctrl, const char *cmd, size_t cmd_len,
-                     char *reply, size_t *reply_len,
-                     void (*msg_cb)(char *msg, size_t len)) {
-  struct timeval tv;
-  struct os_reltime started_at;
+static void wpa_ctrl_deadline(struct os_reltime *deadline, int timeout_ms) {
+  os_get_reltime(deadline);
+  deadline->sec += timeout_ms / 1000;
+  deadline->usec += (timeout_ms % 1000) * 1000;
+  if (deadline->usec >= 1000000) {
+    deadline->sec++;
+    deadline->usec -= 1000000;
+  }
+}
+
+/* Milliseconds left until deadline, rounded up; 0 if it has passed. */
+static int wpa_ctrl_remaining_ms(struct os_reltime *deadline) {
+  struct os_reltime now, left;
+
+  os_get_reltime(&now);
+  if (!os_reltime_before(&now, deadline)) return 0;
+  os_reltime_sub(deadline, &now, &left);
+  return left.sec * 1000 + (left.usec + 999) / 1000;
+}
+
+static int wpa_ctrl_request_until(struct wpa_ctrl *ctrl, const char *cmd,
+                                  size_t cmd_len, char *reply,
+                                  size_t *reply_len,
+                                  void (*msg_cb)(char *msg, size_t len),
+                                  struct os_reltime *deadline, int wake_fd) {
   int res;
-  fd_set rfds;
+  struct pollfd pfd[2];
+  nfds_t nfds;
   const char *_cmd;
   char *cmd_buf = NULL;
   size_t _cmd_len;
@@ -458,42 +527,51 @@ int wpa_ctrl_request(struct wpa_ctrl *ctrl, const char *cmd, size_t cmd_len,
     _cmd_len = cmd_len;
   }
 
+  pfd[0].fd = ctrl->s;
+  pfd[0].events = POLLOUT;
+  nfds = 1;
+  if (wake_fd >= 0) {
+    pfd[1].fd = wake_fd;
+    pfd[1].events = POLLIN;
+    nfds = 2;
+  }
+
   errno = 0;
-  started_at.sec = 0;
-  started_at.usec = 0;
-retry_send:
-  if (send(ctrl->s, _cmd, _cmd_len, 0) < 0) {
-    if (errno == EAGAIN || errno == EBUSY || errno == EWOULDBLOCK) {
-      /*
-       * Must be a non-blocking socket... Try for a bit
-       * longer before giving up.
-       */
-      if (started_at.sec == 0)
-        os_get_reltime(&started_at);
-      else {
-        struct os_reltime n;
-        os_get_reltime(&n);
-        /* Try for a few seconds. */
-        if (os_reltime_expired(&n, &started_at, 5)) goto send_err;
-      }
-      os_sleep(1, 0);
-      goto retry_send;
+  while (send(ctrl->s, _cmd, _cmd_len, 0) < 0) {
+    if (errno != EAGAIN && errno != EBUSY && errno != EWOULDBLOCK) {
+      res = -1;
+      goto send_done;
+    }
+
+    /*
+     * Must be a non-blocking socket whose peer is backed up. Wait until it can
+     * take the request rather than sleeping for a fixed time.
+     */
+    res = poll(pfd, nfds, wpa_ctrl_remaining_ms(deadline));
+    if (res < 0 && errno == EINTR) continue;
+    if (res < 0) goto send_done;
+    if (res == 0) {
+      res = -2;
+      goto send_done;
+    }
+    if (nfds == 2 && pfd[1].revents) {
+      res = -4;
+      goto send_done;
     }
-  send_err:
-    os_free(cmd_buf);
-    return -1;
   }
+  res = 0;
+send_done:
   os_free(cmd_buf);
+  if (res < 0) return res;
 
+  pfd[0].events = POLLIN;
   for (;;) {
-    tv.tv_sec = 10;
-    tv.tv_usec = 0;
-    FD_ZERO(&rfds);
-    FD_SET(ctrl->s, &rfds);
-    res = select(ctrl->s + 1, &rfds, NULL, NULL, &tv);
+    res = poll(pfd, nfds, wpa_ctrl_remaining_ms(deadline));
     if (res < 0 && errno == EINTR) continue;
     if (res < 0) return res;
-    if (FD_ISSET(ctrl->s, &rfds)) {
+    if (res == 0) return -2;
+    if (nfds == 2 && pfd[1].revents) return -4;
+    if (pfd[0].revents) {
       res = recv(ctrl->s, reply, *reply_len, 0);
       if (res < 0) return res;
       if (res > 0 && reply[0] == '<') {
@@ -512,12 +590,68 @@ retry_send:
       }
       *reply_len = res;
       break;
-    } else {
-      return -2;
     }
   }
   return 0;
 }
+
+int wpa_ctrl_request_timed(struct wpa_ctrl *ctrl, const char *cmd,
+                           size_t cmd_len, char *reply, size_t *reply_len,
+                           void (*msg_cb)(char *msg, size_t len),
+                           int timeout_ms, int wake_fd) {
+  struct os_reltime deadline;
+
+  wpa_ctrl_deadline(&deadline, timeout_ms);
+  return wpa_ctrl_request_until(ctrl, cmd, cmd_len, reply, reply_len, msg_cb,
+                                &deadline, wake_fd);
+}
+
+int wpa_ctrl_request(struct wpa_ctrl *ctrl, const char *cmd, size_t cmd_len,
+                     char *reply, size_t *reply_len,
+                     void (*msg_cb)(char *msg, size_t len)) {
+  return wpa_ctrl_request_timed(ctrl, cmd, cmd_len, reply, reply_len, msg_cb,
+                                10 * 1000, -1);
+}
+
+int wpa_ctrl_sta_walk(struct wpa_ctrl *ctrl, char *buf, size_t buf_len,
+                      size_t *used, size_t *last, int timeout_ms,
+                      int wake_fd) {
+  struct os_reltime deadline;
+  char cmd[64];
+  size_t cmd_len, len, addr_len;
+  const char *nl;
+  int res;
+
+  wpa_ctrl_deadline(&deadline, timeout_ms);
+  for (;;) {
+    if (*used == 0) {
+      cmd_len = os_strlcpy(cmd, "STA-FIRST", sizeof(cmd));
+    } else {
+      /* The first line of a STA reply is the address to continue from. */
+      nl = memchr(buf + *last, '\n', *used - *last);
+      addr_len = nl ? (size_t)(nl - (buf + *last)) : *used - *last;
+      if (addr_len == 0 || addr_len > sizeof(cmd) - 10) return -1;
+      os_memcpy(cmd, "STA-NEXT ", 9);
+      os_memcpy(cmd + 9, buf + *last, addr_len);
+      cmd_len = 9 + addr_len;
+    }
+
+    /* Leave room to newline-terminate the reply. */
+    if (buf_len - *used < 2) return -3;
+    len = buf_len - *used - 1;
+    res = wpa_ctrl_request_until(ctrl, cmd, cmd_len, buf + *used, &len, NULL,
+                                 &deadline, wake_fd);
+    if (res < 0) return res;
+    /* A reply that fills the rest of the buffer may have been truncated. */
+    if (len == buf_len - *used - 1) return -3;
+    if (len == 0 || (len == 5 && os_memcmp(buf + *used, "FAIL\n", 5) == 0))
+      return 0;
+
+    *last = *used;
+    *used += len;
+    if (buf[*used - 1] != '\n') buf[(*used)++] = '\n';
+  }
+}
 #endif /* CTRL_IFACE_SOCKET */
 
 static int wpa_ctrl_attach_helper(struct wpa_ctrl *ctrl, int attach) {
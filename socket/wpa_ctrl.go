@@ -5,39 +5,148 @@ package socket
 // #include <wpa_ctrl.h>
 import "C"
 import (
+	"bytes"
+	"context"
 	"fmt"
+	"math"
 	"sync"
+	"syscall"
+	"time"
 	"unsafe"
 )
 
 type Socket interface {
 	SendRawCmd(string) (string, error)
+
+	// Like SendRawCmd but bounded by ctx's deadline and abandoned as soon as ctx
+	// is done.
+	SendRawCmdContext(context.Context, string) (string, error)
+
+	// Returns the replies to STA-FIRST and each following STA-NEXT back to back.
+	// The whole walk happens in one call into C.
+	ListStations(context.Context) (string, error)
+
+	// Like SendRawCmdContext and ListStations but append the reply to dst
+	// instead of copying it into a new string. With a dst that is big enough
+	// nothing is allocated.
+	AppendRawCmd(ctx context.Context, dst []byte, cmd string) ([]byte, error)
+	AppendStations(ctx context.Context, dst []byte) ([]byte, error)
+
 	Close() error
 }
 
 type wpaCtrl struct {
 	ctrl *C.struct_wpa_ctrl
-	mu   sync.Mutex
+
+	// Guards the reply buffer, which is reused across requests and grown
+	// whenever a reply fills it completely since that means the datagram may
+	// have been truncated. The command buffer is reused the same way.
+	mu      sync.Mutex
+	buf     *C.char
+	bufSize int
+	cmd     *C.char
+	cmdSize int
+
+	// Out parameters of the C calls. Locals would escape to the heap.
+	replySize, used, last C.size_t
+
+	// A pipe whose read end is polled alongside the control socket while a
+	// request is in flight. Writing to it abandons the request.
+	wakeR, wakeW int
 }
 
-func Open(device, clientDir string) (Socket, error) {
+const (
+	// hostapd never sends a reply larger than 4096 bytes so a reply from a stock
+	// build always fits. The bigger ones come from bulk commands (ALL_STA).
+	initialReplySize = 8192
+	maxReplySize     = 256 << 10
+
+	// A station walk is many replies in one buffer. A STA reply is up to about
+	// 1 KiB, so this is enough for thousands of stations.
+	maxWalkSize = 16 << 20
+
+	// What wpa_ctrl_request has always used when the caller has no deadline.
+	defaultTimeout = 10 * time.Second
+)
+
+// C copies of the commands sent most often. They are never freed.
+var constCmds = make(map[string]*C.char)
+
+func init() {
+	for _, cmd := range []string{"PING", "STA-FIRST", "ALL_STA"} {
+		constCmds[cmd] = C.CString(cmd)
+	}
+}
+
+// Options tune the client end of control connections.
+type Options struct {
+	// SO_SNDBUF and SO_RCVBUF for the client socket. Zero keeps the system
+	// default.
+	SendBuffer, RecvBuffer int
+
+	// Binds the client socket in the abstract namespace (named after the
+	// client dir) so that no file is created or unlinked. hostapd must be in
+	// the same network namespace.
+	Abstract bool
+}
+
+func openCtrl(device, clientDir string, opts Options) (*C.struct_wpa_ctrl, error) {
 	deviceCstr, clientDirCstr := C.CString(device), C.CString(clientDir)
 	defer func() {
 		C.free(unsafe.Pointer(deviceCstr))
 		C.free(unsafe.Pointer(clientDirCstr))
 	}()
 
-	ctrl, err := C.wpa_ctrl_open2(deviceCstr, clientDirCstr)
+	cOpts := C.struct_wpa_ctrl_opts{
+		sndbuf: C.int(opts.SendBuffer),
+		rcvbuf: C.int(opts.RecvBuffer),
+	}
+	if opts.Abstract {
+		cOpts.abstract = 1
+	}
+	// errno can be left set by steps that were retried or aren't fatal, so only
+	// a nil ctrl means failure.
+	ctrl, err := C.wpa_ctrl_open3(deviceCstr, clientDirCstr, &cOpts)
+	if ctrl == nil {
+		if err == nil {
+			err = fmt.Errorf("socket: could not open %q", device)
+		}
+		return nil, err
+	}
+	return ctrl, nil
+}
+
+func Open(device, clientDir string) (Socket, error) {
+	return OpenWithOptions(device, clientDir, Options{})
+}
+
+func OpenWithOptions(device, clientDir string, opts Options) (Socket, error) {
+	ctrl, err := openCtrl(device, clientDir, opts)
 	if err != nil {
 		return nil, err
 	}
 
-	return &wpaCtrl{ctrl: ctrl}, nil
+	var wake [2]int
+	if err := syscall.Pipe2(wake[:], syscall.O_CLOEXEC|syscall.O_NONBLOCK); err != nil {
+		C.wpa_ctrl_close(ctrl)
+		return nil, err
+	}
+
+	return &wpaCtrl{ctrl: ctrl, wakeR: wake[0], wakeW: wake[1]}, nil
 }
 
 func (c *wpaCtrl) Close() (err error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
 	_, err = C.wpa_ctrl_close(c.ctrl)
 	c.ctrl = nil
+	C.free(unsafe.Pointer(c.buf))
+	c.buf, c.bufSize = nil, 0
+	C.free(unsafe.Pointer(c.cmd))
+	c.cmd, c.cmdSize = nil, 0
+	syscall.Close(c.wakeR)
+	syscall.Close(c.wakeW)
 	return
 }
 
@@ -46,6 +155,8 @@ type Code int
 const (
 	Internal Code = -(iota + 1)
 	DeadlineExceeded
+	ReplyTooLarge
+	Canceled
 )
 
 type RequestError struct {
@@ -57,25 +168,240 @@ func (err *RequestError) Error() string {
 	return fmt.Sprintf("socket request error code %d: %v", err.Code, err.Errno)
 }
 
+// Whether err means a request was given up on before hostapd replied. The
+// reply may still arrive later, so the connection it was sent on can't be
+// trusted to pair the next request with the right reply.
+func isAbandoned(err error) bool {
+	reqErr, ok := err.(*RequestError)
+	return ok && (reqErr.Code == DeadlineExceeded || reqErr.Code == Canceled)
+}
+
+// c.mu must be held.
+func (c *wpaCtrl) growBuf(size int) {
+	buf := C.realloc(unsafe.Pointer(c.buf), C.size_t(size))
+	if buf == nil {
+		panic("socket: out of memory")
+	}
+	c.buf, c.bufSize = (*C.char)(buf), size
+}
+
+// Returns req as a C string, which isn't NUL terminated unless it is one of
+// constCmds. c.mu must be held.
+func (c *wpaCtrl) cmdBuf(req string) *C.char {
+	if cs, ok := constCmds[req]; ok {
+		return cs
+	}
+	if len(req) > c.cmdSize {
+		size := 2 * c.cmdSize
+		if size < 64 {
+			size = 64
+		}
+		for size < len(req) {
+			size *= 2
+		}
+		cmd := C.realloc(unsafe.Pointer(c.cmd), C.size_t(size))
+		if cmd == nil {
+			panic("socket: out of memory")
+		}
+		c.cmd, c.cmdSize = (*C.char)(cmd), size
+	}
+	copy(cBytes(c.cmd, len(req)), req)
+	return c.cmd
+}
+
+// A view of n bytes of C memory at p.
+func cBytes(p *C.char, n int) []byte {
+	if n == 0 {
+		return nil
+	}
+	return (*[1 << 30]byte)(unsafe.Pointer(p))[:n:n]
+}
+
+func timeoutMs(ctx context.Context) C.int {
+	d, ok := ctx.Deadline()
+	if !ok {
+		return C.int(defaultTimeout / time.Millisecond)
+	}
+	ms := (time.Until(d) + time.Millisecond - 1) / time.Millisecond
+	if ms < 0 {
+		ms = 0
+	} else if ms > math.MaxInt32 {
+		ms = math.MaxInt32
+	}
+	return C.int(ms)
+}
+
+// Wakes up the request in flight on c once ctx is done. The returned func must
+// be called after the request returns; it leaves the wake pipe empty for the
+// next one. c.mu must be held.
+func (c *wpaCtrl) watch(ctx context.Context) (stop func()) {
+	if ctx.Done() == nil {
+		return func() {}
+	}
+
+	done, exited := make(chan struct{}), make(chan struct{})
+	go func() {
+		defer close(exited)
+		select {
+		case <-ctx.Done():
+			syscall.Write(c.wakeW, []byte{0})
+		case <-done:
+		}
+	}()
+
+	return func() {
+		close(done)
+		<-exited
+		if ctx.Err() != nil {
+			var b [16]byte
+			for {
+				if n, _ := syscall.Read(c.wakeR, b[:]); n <= 0 {
+					break
+				}
+			}
+		}
+	}
+}
+
+func requestError(ctx context.Context, ret C.int, errno error) error {
+	if Code(ret) == Canceled {
+		if ctx.Err() == context.DeadlineExceeded {
+			return &RequestError{Errno: ctx.Err(), Code: DeadlineExceeded}
+		}
+		return &RequestError{Errno: ctx.Err(), Code: Canceled}
+	}
+	return &RequestError{Errno: errno, Code: Code(ret)}
+}
+
 func (c *wpaCtrl) SendRawCmd(req string) (string, error) {
-	const bufSize = 4096
-	buf := (*C.char)(C.malloc(bufSize))
-	defer C.free(unsafe.Pointer(buf))
-
-	cs := C.CString(req)
-	defer C.free(unsafe.Pointer(cs))
-
-	replySize := C.size_t(bufSize)
-	ret, err := C.wpa_ctrl_request(c.ctrl, cs, C.size_t(len(req)), (*C.char)(buf), &replySize, nil)
-	if ret != 0 {
-		return "", &RequestError{
-			Errno: err,
-			Code:  Code(ret),
+	return c.SendRawCmdContext(context.Background(), req)
+}
+
+func (c *wpaCtrl) SendRawCmdContext(ctx context.Context, req string) (string, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	n, err := c.request(ctx, req)
+	if err != nil {
+		return "", err
+	}
+	return C.GoStringN(c.buf, C.int(n)), nil
+}
+
+func (c *wpaCtrl) AppendRawCmd(ctx context.Context, dst []byte, req string) ([]byte, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	n, err := c.request(ctx, req)
+	if err != nil {
+		return dst, err
+	}
+	return append(dst, cBytes(c.buf, n)...), nil
+}
+
+// Leaves the reply in the first n bytes of c.buf. If a reply fills the whole
+// buffer, the command is sent again with a bigger buffer. That is only safe
+// because every command sent is a query. A reply that fills the biggest buffer
+// may have been cut short, so it is an error as on the other engines. c.mu must
+// be held.
+func (c *wpaCtrl) request(ctx context.Context, req string) (n int, err error) {
+	cs := c.cmdBuf(req)
+
+	stop := c.watch(ctx)
+	defer stop()
+
+	if c.buf == nil {
+		c.growBuf(initialReplySize)
+	}
+	for {
+		c.replySize = C.size_t(c.bufSize)
+		ret, err := C.wpa_ctrl_request_timed(c.ctrl, cs, C.size_t(len(req)), c.buf, &c.replySize, nil, timeoutMs(ctx), C.int(c.wakeR))
+		if ret != 0 {
+			return 0, requestError(ctx, ret, err)
+		}
+
+		replySize := c.replySize
+		if int(replySize) > c.bufSize {
+			panic("socket: wpa_ctrl_request maybe wrote past the end")
+		}
+		if int(replySize) == c.bufSize {
+			if c.bufSize >= maxReplySize {
+				return 0, &RequestError{Code: ReplyTooLarge}
+			}
+			c.growBuf(2 * c.bufSize)
+			continue
+		}
+		return int(replySize), nil
+	}
+}
+
+func (c *wpaCtrl) ListStations(ctx context.Context) (string, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	n, err := c.walk(ctx)
+	if err != nil {
+		return "", err
+	}
+	return C.GoStringN(c.buf, C.int(n)), nil
+}
+
+func (c *wpaCtrl) AppendStations(ctx context.Context, dst []byte) ([]byte, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	n, err := c.walk(ctx)
+	if err != nil {
+		return dst, err
+	}
+	return append(dst, cBytes(c.buf, n)...), nil
+}
+
+// Leaves the walk in the first n bytes of c.buf. c.mu must be held.
+func (c *wpaCtrl) walk(ctx context.Context) (n int, err error) {
+	stop := c.watch(ctx)
+	defer stop()
+
+	if c.buf == nil {
+		c.growBuf(initialReplySize)
+	}
+	c.used, c.last = 0, 0
+	for {
+		ret, err := C.wpa_ctrl_sta_walk(c.ctrl, c.buf, C.size_t(c.bufSize), &c.used, &c.last, timeoutMs(ctx), C.int(c.wakeR))
+		if Code(ret) == ReplyTooLarge && c.bufSize < maxWalkSize {
+			// Resumes from the last station that fit.
+			c.growBuf(2 * c.bufSize)
+			continue
 		}
+		if ret != 0 {
+			return 0, requestError(ctx, ret, err)
+		}
+		return int(c.used), nil
 	}
+}
+
+// Does the same walk as wpa_ctrl_sta_walk with one request per step, for
+// engines that don't go through C. Replies are appended to dst and cmd is
+// scratch space for the commands.
+func walkStations(dst, cmd []byte, do func(dst, cmd []byte) ([]byte, error)) ([]byte, []byte, error) {
+	cmd = append(cmd[:0], "STA-FIRST"...)
+	for {
+		start := len(dst)
+		var err error
+		if dst, err = do(dst, cmd); err != nil {
+			return dst[:start], cmd, err
+		}
 
-	if replySize > bufSize {
-		panic("socket: wpa_ctrl_request maybe wrote past the end")
+		res := dst[start:]
+		if len(res) == 0 || string(res) == "FAIL\n" {
+			return dst[:start], cmd, nil
+		}
+		addr := res
+		if i := bytes.IndexByte(res, '\n'); i != -1 {
+			addr = res[:i]
+		} else {
+			dst = append(dst, '\n')
+		}
+		cmd = append(append(cmd[:0], "STA-NEXT "...), addr...)
 	}
-	return C.GoStringN(buf, C.int(replySize)), nil
 }
@@ -421,6 +421,33 @@ struct wpa_ctrl *wpa_ctrl_open(const char *ctrl_path);
  */
 struct wpa_ctrl *wpa_ctrl_open2(const char *ctrl_path, const char *cli_path);
 
+/**
+ * struct wpa_ctrl_opts - Options for wpa_ctrl_open3()
+ * @sndbuf: SO_SNDBUF for the client socket, or 0 to keep the system default
+ * @rcvbuf: SO_RCVBUF for the client socket, or 0 to keep the system default
+ * @abstract: Bind the client socket in the Linux abstract namespace, named
+ *            after cli_path, instead of creating a file in cli_path. The
+ *            server must share the client's network namespace.
+ */
+struct wpa_ctrl_opts {
+  int sndbuf;
+  int rcvbuf;
+  int abstract;
+};
+
+/**
+ * wpa_ctrl_open3 - Open a control interface with extra socket options
+ * @ctrl_path: Path for UNIX domain sockets
+ * @cli_path: Path for client UNIX domain sockets
+ * @opts: Options for the client socket, or %NULL for the defaults
+ * Returns: Pointer to abstract control interface data or %NULL on failure
+ *
+ * This is wpa_ctrl_open2() with a way to tune the client socket. Only UNIX
+ * domain sockets are supported.
+ */
+struct wpa_ctrl *wpa_ctrl_open3(const char *ctrl_path, const char *cli_path,
+                                const struct wpa_ctrl_opts *opts);
+
 /**
  * wpa_ctrl_close - Close a control interface to wpa_supplicant/hostapd
  * @ctrl: Control interface data from wpa_ctrl_open()
@@ -459,6 +486,57 @@ int wpa_ctrl_request(struct wpa_ctrl *ctrl, const char *cmd, size_t cmd_len,
                      char *reply, size_t *reply_len,
                      void (*msg_cb)(char *msg, size_t len));
 
+/**
+ * wpa_ctrl_request_timed - Send a command with a deadline and wakeup fd
+ * @ctrl: Control interface data from wpa_ctrl_open()
+ * @cmd: Command; usually, ASCII text, e.g., "PING"
+ * @cmd_len: Length of the cmd in bytes
+ * @reply: Buffer for the response
+ * @reply_len: Reply buffer length
+ * @msg_cb: Callback function for unsolicited messages or %NULL if not used
+ * @timeout_ms: How long to wait for the reply in total
+ * @wake_fd: File descriptor that aborts the request when it becomes readable,
+ * or -1
+ * Returns: 0 on success, -1 on error (send or receive failed), -2 on timeout,
+ * -4 if woken up through wake_fd
+ *
+ * This is wpa_ctrl_request() with the wait bounded by a single deadline rather
+ * than restarting a fixed timeout after every unsolicited message, and with a
+ * way for another thread to abandon the request. wake_fd is only polled; it is
+ * up to the caller to drain it. An abandoned request may still be answered, so
+ * the connection should not be reused for another request afterwards.
+ */
+int wpa_ctrl_request_timed(struct wpa_ctrl *ctrl, const char *cmd,
+                           size_t cmd_len, char *reply, size_t *reply_len,
+                           void (*msg_cb)(char *msg, size_t len),
+                           int timeout_ms, int wake_fd);
+
+/**
+ * wpa_ctrl_sta_walk - Fetch every station with STA-FIRST/STA-NEXT
+ * @ctrl: Control interface data from wpa_ctrl_open()
+ * @buf: Buffer for the concatenated replies
+ * @buf_len: Length of buf
+ * @used: Number of bytes of buf holding replies; 0 to start a new walk
+ * @last: Offset in buf of the last reply, which the walk continues from
+ * @timeout_ms: How long the whole walk may take
+ * @wake_fd: As for wpa_ctrl_request_timed()
+ * Returns: 0 on success, -1 on error (send or receive failed), -2 on timeout,
+ * -3 if buf is too small for the next reply, -4 if woken up through wake_fd
+ *
+ * This function walks the station table with one wpa_ctrl_request() per
+ * station, taking the address for each STA-NEXT from the first line of the
+ * previous reply, so that callers crossing a language boundary pay for it once
+ * per walk rather than once per station. The replies are written back to back,
+ * each terminated by a newline.
+ *
+ * On -3, @used and @last still describe the complete replies so far; the
+ * caller can grow buf (preserving its contents) and call again to resume the
+ * walk where it stopped.
+ */
+int wpa_ctrl_sta_walk(struct wpa_ctrl *ctrl, char *buf, size_t buf_len,
+                      size_t *used, size_t *last, int timeout_ms,
+                      int wake_fd);
+
 /**
  * wpa_ctrl_attach - Register as an event monitor for the control interface
  * @ctrl: Control interface data from wpa_ctrl_open()
@@ -0,0 +1,138 @@
+package socket
+
+import (
+	"bytes"
+	"context"
+	"path/filepath"
+	"testing"
+
+	"go.jonnrb.io/hostapd_grpc/fakehostapd"
+)
+
+const benchStations = 30
+
+func TestListStationsMatchesStepByStep(t *testing.T) {
+	h, clientDir := startFake(t, 1, fakehostapd.Options{Stations: benchStations})
+	c := openFake(t, h, clientDir, "wlan0")
+
+	ctx := context.Background()
+	walked, err := c.AppendStations(ctx, nil)
+	if err != nil {
+		t.Fatal(err)
+	}
+	stepped, _, err := walkStations(nil, nil, func(dst, cmd []byte) ([]byte, error) {
+		return c.AppendRawCmd(ctx, dst, string(cmd))
+	})
+	if err != nil {
+		t.Fatal(err)
+	}
+	if n := bytes.Count(walked, []byte("\nflags=")); n != benchStations {
+		t.Errorf("walk has %d stations; want %d", n, benchStations)
+	}
+	if !bytes.Equal(walked, stepped) {
+		t.Errorf("walk in C differs from walk in Go:\n%s\nvs\n%s", walked, stepped)
+	}
+}
+
+// Walks the stations with a cgo call per STA-FIRST and STA-NEXT against one
+// cgo call for the whole walk (wpa_ctrl_sta_walk). Both make the same round
+// trips to hostapd.
+func BenchmarkStationWalk(b *testing.B) {
+	h, clientDir := startFake(b, 1, fakehostapd.Options{Stations: benchStations})
+	iface := h.Interface("wlan0")
+	ctx := context.Background()
+
+	b.Run("request-per-station", func(b *testing.B) {
+		c := openFake(b, h, clientDir, "wlan0")
+		var (
+			buf, cmd []byte
+			calls    int
+			err      error
+		)
+		b.ResetTimer()
+		start := iface.Requests()
+		for i := 0; i < b.N; i++ {
+			buf, cmd, err = walkStations(buf[:0], cmd, func(dst, cmd []byte) ([]byte, error) {
+				calls++
+				return c.AppendRawCmd(ctx, dst, string(cmd))
+			})
+			if err != nil {
+				b.Fatal(err)
+			}
+		}
+		b.ReportMetric(float64(calls)/float64(b.N), "cgo-calls/op")
+		b.ReportMetric(float64(iface.Requests()-start)/float64(b.N), "round-trips/op")
+	})
+
+	b.Run("single-call", func(b *testing.B) {
+		c := openFake(b, h, clientDir, "wlan0")
+		var (
+			buf   []byte
+			calls int
+			err   error
+		)
+		b.ResetTimer()
+		start := iface.Requests()
+		for i := 0; i < b.N; i++ {
+			// wpa_ctrl_sta_walk is called again each time the buffer grows.
+			size := c.bufSize
+			if buf, err = c.AppendStations(ctx, buf[:0]); err != nil {
+				b.Fatal(err)
+			}
+			calls++
+			for ; size != 0 && size < c.bufSize; size *= 2 {
+				calls++
+			}
+		}
+		b.ReportMetric(float64(calls)/float64(b.N), "cgo-calls/op")
+		b.ReportMetric(float64(iface.Requests()-start)/float64(b.N), "round-trips/op")
+	})
+}
+
+// Counts what a request costs the client: the fake runs in another process.
+// SendRawCmd and ListStations copy the reply into a new string; the Append
+// variants reuse the caller's buffer.
+func BenchmarkRequestAllocs(b *testing.B) {
+	dir, clientDir := startFakeProcess(b, 1, fakehostapd.Options{Stations: benchStations})
+	s, err := Open(filepath.Join(dir, "wlan0"), clientDir)
+	if err != nil {
+		b.Fatal(err)
+	}
+	defer s.Close()
+	ctx := context.Background()
+
+	b.Run("PING/SendRawCmd", func(b *testing.B) {
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			if _, err := s.SendRawCmdContext(ctx, "PING"); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+	b.Run("PING/AppendRawCmd", func(b *testing.B) {
+		var buf [16]byte
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			if _, err := s.AppendRawCmd(ctx, buf[:0], "PING"); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+	b.Run("walk/ListStations", func(b *testing.B) {
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			if _, err := s.ListStations(ctx); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+	b.Run("walk/AppendStations", func(b *testing.B) {
+		var buf []byte
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			if buf, err = s.AppendStations(ctx, buf[:0]); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+}